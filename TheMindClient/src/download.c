@@ -0,0 +1,239 @@
+//
+// Created by erwan on 19/10/2026.
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "download.h"
+
+static int connect_dl(const Downloader *dl) {
+    int socket_fd = socket(PF_INET, SOCK_STREAM, 0);
+    if (socket_fd == -1) {
+        perror("Erreur lors de la création de la socket de téléchargement");
+        return -1;
+    }
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(dl->port);
+    if (inet_pton(AF_INET, dl->ip, &server_addr.sin_addr) <= 0
+        || connect(socket_fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+        perror("Erreur lors de la connection au serveur de téléchargement");
+        close(socket_fd);
+        return -1;
+    }
+    return socket_fd;
+}
+
+/**
+ * @brief Open a connection to the download server and send a request.
+ * @return The socket, or -1 on error.
+ */
+static int request(const Downloader *dl, const char *msg) {
+    int socket_fd = connect_dl(dl);
+    if (socket_fd == -1) return -1;
+    if (send(socket_fd, msg, strlen(msg), 0) < 0) {
+        perror("Erreur lors de l'envoie de la requête");
+        close(socket_fd);
+        return -1;
+    }
+    return socket_fd;
+}
+
+/**
+ * @brief FNV-1a hash of a file, the same as the server.
+ */
+static uint64_t hash_file(FILE *file) {
+    uint64_t hash = 14695981039346656037ULL;
+    unsigned char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0) {
+        for (size_t i = 0; i < n; ++i) {
+            hash = (hash ^ buf[i]) * 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+static int local_hash(const char *path, uint64_t *hash) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return -1;
+    *hash = hash_file(file);
+    fclose(file);
+    return 0;
+}
+
+/**
+ * @brief Ask the size and the hash of a file to the server.
+ * @return 0 on success, -1 if the file is unknown or the server can't be reached.
+ */
+static int remote_stat(const Downloader *dl, const char *filename, long *size, uint64_t *hash) {
+    char msg[256];
+    snprintf(msg, sizeof(msg), "stat %s", filename);
+    int socket_fd = request(dl, msg);
+    if (socket_fd == -1) return -1;
+
+    char reply[128];
+    size_t used = 0;
+    ssize_t n;
+    while (used < sizeof(reply) - 1 && (n = recv(socket_fd, reply + used, sizeof(reply) - 1 - used, 0)) > 0) {
+        used += n;
+    }
+    reply[used] = '\0';
+    close(socket_fd);
+
+    unsigned long long h;
+    if (sscanf(reply, "%ld %llx", size, &h) != 2) {
+        printf("Téléchargement de %s impossible : %s", filename, used > 0 ? reply : "pas de réponse\n");
+        return -1;
+    }
+    *hash = h;
+    return 0;
+}
+
+/**
+ * @brief Download a file, resuming a partial local copy.
+ */
+static void download(const Downloader *dl, const char *filename) {
+    long size;
+    uint64_t hash;
+    if (remote_stat(dl, filename, &size, &hash) == -1) return;
+
+    char path[256];
+    snprintf(path, sizeof(path), DL_DIR"/%s", filename);
+    struct stat st;
+    long offset = stat(path, &st) == 0 ? (long)st.st_size : 0;
+    uint64_t current;
+    if (offset == size && local_hash(path, &current) == 0 && current == hash) {
+        printf("%s est déjà téléchargé.\n", path);
+        return;
+    }
+    if (offset >= size) offset = 0; // Another file with the same name, downloaded again
+
+    char msg[256];
+    snprintf(msg, sizeof(msg), "getfile %s %ld", filename, offset);
+    int socket_fd = request(dl, msg);
+    if (socket_fd == -1) return;
+
+    FILE *file = fopen(path, offset > 0 ? "ab" : "wb");
+    if (file == NULL) {
+        perror("Erreur lors de l'ouverture du fichier local");
+        close(socket_fd);
+        return;
+    }
+    if (offset > 0) {
+        printf("Reprise du téléchargement de %s à %ld/%ld octets...\n", path, offset, size);
+    } else {
+        printf("Téléchargement en cours vers %s ...\n", path);
+    }
+
+    char buffer[BUFSIZ];
+    ssize_t b_received;
+    long received = offset;
+    int next_step = (int)(size > 0 ? received * 100 / size : 0) / DL_PROGRESS_STEP * DL_PROGRESS_STEP + DL_PROGRESS_STEP;
+    while ((b_received = recv(socket_fd, buffer, sizeof(buffer), 0)) > 0) {
+        if (fwrite(buffer, 1, b_received, file) != (size_t)b_received) {
+            perror("Erreur lors de l'écriture dans le fichier");
+            break;
+        }
+        received += b_received;
+        int percent = size > 0 ? (int)(received * 100 / size) : 100;
+        if (percent >= next_step && percent < 100) {
+            printf("%s : %d%%\n", filename, percent);
+            next_step = percent / DL_PROGRESS_STEP * DL_PROGRESS_STEP + DL_PROGRESS_STEP;
+        }
+    }
+    if (b_received < 0) perror("Erreur lors de la réception des données");
+    fclose(file);
+    close(socket_fd);
+
+    if (received < size) {
+        printf("Téléchargement de %s interrompu à %ld/%ld octets, il reprendra à la prochaine demande.\n", filename, received, size);
+    } else if (local_hash(path, &current) == 0 && current == hash) {
+        printf("Téléchargement de %s terminé avec succès.\n", filename);
+    } else {
+        printf("Le fichier %s est corrompu, il est supprimé.\n", path);
+        unlink(path);
+    }
+}
+
+static void *run_downloader(void *arg) {
+    Downloader *dl = arg;
+    char filename[DL_NAME_SIZE];
+    while (1) {
+        pthread_mutex_lock(&dl->mutex);
+        while (dl->running && dl->count == 0) {
+            pthread_cond_wait(&dl->cond, &dl->mutex);
+        }
+        if (!dl->running) {
+            pthread_mutex_unlock(&dl->mutex);
+            break;
+        }
+        memcpy(filename, dl->queue[dl->head], DL_NAME_SIZE);
+        dl->head = (dl->head + 1) % DL_QUEUE_SIZE;
+        dl->count--;
+        pthread_mutex_unlock(&dl->mutex);
+
+        download(dl, filename);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Start the download worker.
+ * @param port Port of the download server.
+ * @return 0 on success, -1 if the thread can't be created.
+ */
+int start_downloader(Downloader *dl, const char *ip, int port) {
+    dl->head = 0;
+    dl->count = 0;
+    dl->running = true;
+    dl->ip = ip;
+    dl->port = port;
+    pthread_mutex_init(&dl->mutex, NULL);
+    pthread_cond_init(&dl->cond, NULL);
+    if (pthread_create(&dl->thread, NULL, run_downloader, dl) != 0) {
+        perror("ERROR : download thread creation");
+        pthread_mutex_destroy(&dl->mutex);
+        pthread_cond_destroy(&dl->cond);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Stop the worker after its current download, the queued files are dropped.
+ */
+void stop_downloader(Downloader *dl) {
+    pthread_mutex_lock(&dl->mutex);
+    dl->running = false;
+    pthread_cond_signal(&dl->cond);
+    pthread_mutex_unlock(&dl->mutex);
+    pthread_join(dl->thread, NULL);
+    pthread_mutex_destroy(&dl->mutex);
+    pthread_cond_destroy(&dl->cond);
+}
+
+/**
+ * @brief Queue a file for the worker, never blocks.
+ * @return 0 on success, -1 if the queue is full or the name too long.
+ */
+int queue_download(Downloader *dl, const char *filename) {
+    if (strlen(filename) >= DL_NAME_SIZE) return -1;
+    pthread_mutex_lock(&dl->mutex);
+    if (dl->count == DL_QUEUE_SIZE) {
+        pthread_mutex_unlock(&dl->mutex);
+        return -1;
+    }
+    snprintf(dl->queue[(dl->head + dl->count) % DL_QUEUE_SIZE], DL_NAME_SIZE, "%s", filename);
+    dl->count++;
+    pthread_cond_signal(&dl->cond);
+    pthread_mutex_unlock(&dl->mutex);
+    return 0;
+}
@@ -0,0 +1,38 @@
+//
+// Created by erwan on 19/10/2026.
+//
+
+#ifndef THEMINDCLIENT_DOWNLOAD_H
+#define THEMINDCLIENT_DOWNLOAD_H
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#define DL_DIR "./pdf"
+#define DL_QUEUE_SIZE 16 // Files waiting for the worker
+#define DL_NAME_SIZE 200
+#define DL_PROGRESS_STEP 25 // Progress printed every step, in percent
+
+/**
+ * @struct Downloader
+ * @brief Worker downloading the stats files in the background, so that the reader thread never waits.
+ *
+ * Files already present with the same size and hash are skipped, partial files are resumed.
+ */
+typedef struct {
+    char queue[DL_QUEUE_SIZE][DL_NAME_SIZE];
+    int head;
+    int count;
+    bool running;
+    const char *ip;
+    int port; // Port of the download server
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_t thread;
+} Downloader;
+
+int start_downloader(Downloader *dl, const char *ip, int port);
+void stop_downloader(Downloader *dl);
+int queue_download(Downloader *dl, const char *filename);
+
+#endif //THEMINDCLIENT_DOWNLOAD_H
@@ -6,22 +6,34 @@
 #include <stdbool.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <stdatomic.h>
 #include "utils.h"
+#include "download.h"
 #define RULES_FILE "./ressources/rules.txt"
 #define HELP_FILE "./ressources/help_command.txt"
+#define RECONNECT_TRIES 10 // Attempts to take the seat back after a lost connection
+#define RECONNECT_DELAY 1 // Seconds between two attempts
 
 bool keepalive = true;
 char* s_ip;
 int s_port;
-
-int create_socket(const char* ip, int port){
+Downloader downloader; // Stats files, downloaded in the background
+atomic_bool quitting = false; // The player asked to quit, the connection is not resumed
+char session_token[TOKEN_SIZE]; // Sent by the server to take the seat back, only used by the reader thread
+atomic_bool has_session = false; // A session token can take the seat back, read by the sender thread
+
+/**
+ * @brief Connect to the server.
+ * @return The socket, or -1 on error.
+ */
+int connect_server(const char* ip, int port){
     int socket_fd;
     struct sockaddr_in server_addr;
 
     socket_fd = socket(PF_INET,SOCK_STREAM,0);
     if(socket_fd == -1){
         perror("ERROR creating socket\n");
-        exit(EXIT_FAILURE);
+        return -1;
     }
 
     memset(&server_addr,0,sizeof(server_addr));
@@ -29,67 +41,45 @@ int create_socket(const char* ip, int port){
     server_addr.sin_port = htons(port);
     if(inet_pton(AF_INET,ip,&server_addr.sin_addr) <= 0){
         perror("ERROR invalid ip address\n");
-        exit(EXIT_FAILURE);
+        close(socket_fd);
+        return -1;
     }
 
     if(connect(socket_fd,(struct sockaddr*)&server_addr,sizeof(server_addr)) == -1){
         perror("ERROR connecting to server\n");
-        exit(EXIT_FAILURE);
+        close(socket_fd);
+        return -1;
     }
     return socket_fd;
 }
 
-void download_pdf(const char* filename,int port,const char* ip){
-    int socket_fd = create_socket(ip,port);
-    if(socket_fd < 0){
-        perror("Erreur lors de la connection au serveur de téléchargement");
-        return;
-    }
-    printf("Connection avec le serveur de téléchargement établie...\n");
-
-    char msg[512];
-    snprintf(msg,sizeof(msg),"getfile %s", filename);
-
-    if (send(socket_fd,msg, strlen(msg),0) < 0){
-        perror("Erreur lors de l'envoie de la requête");
-        close(socket_fd);
-        return;
-    }
-
-    char buffer[BUFSIZ];
-    ssize_t b_received;
-    char out_filename[256];
-    snprintf(out_filename,sizeof(out_filename),"./pdf/%s",filename);
+int create_socket(const char* ip, int port){
+    int socket_fd = connect_server(ip,port);
+    if(socket_fd == -1) exit(EXIT_FAILURE);
+    return socket_fd;
+}
 
-    FILE* file = fopen(out_filename,"wb");
-    if(file == NULL){
-        perror("Erreur lors de l'ouverture du fichier local");
+/**
+ * @brief Take the seat back with the session token after a lost connection.
+ * @return The new socket, or -1 if the server can't be reached.
+ */
+static int reconnect(void){
+    for (int i = 1; i <= RECONNECT_TRIES && !atomic_load(&quitting); ++i) {
+        sleep(RECONNECT_DELAY);
+        printf("Reconnexion au serveur (%d/%d) ...\n",i,RECONNECT_TRIES);
+        int socket_fd = connect_server(s_ip,s_port);
+        if(socket_fd == -1) continue;
+        char msg[TOKEN_SIZE + 16];
+        snprintf(msg,sizeof(msg),"resume %s\n",session_token);
+        if(send(socket_fd,msg,strlen(msg),MSG_NOSIGNAL) > 0) return socket_fd;
         close(socket_fd);
-        return;
-    }
-
-    printf("Téléchargement en cours vers %s ...\n",out_filename);
-    while((b_received = recv(socket_fd,buffer,sizeof(buffer),0)) > 0) {
-        if(fwrite(buffer,1,b_received,file) != (size_t)b_received) {
-            perror("Erreur lors de l'écriture dans le fichier");
-            fclose(file);
-            close(socket_fd);
-            return;
-        }
-    }
-
-    if(b_received < 0){
-        perror("Erreur lors de la réception des données");
-    } else {
-        printf("Téléchargement terminé avec succès.\n");
     }
-
-    fclose(file);
-    close(socket_fd);
+    return -1;
 }
 
 void *handle_reader(void * args) {
-    int socket_fd = *(int*)args;
+    atomic_int *server_fd = args;
+    int socket_fd = atomic_load(server_fd);
 
     char buffer[BUFSIZ];
     while(keepalive){
@@ -101,17 +91,30 @@ void *handle_reader(void * args) {
             } else {
                 perror("ERROR receiving message");
             }
-            break;
+            if(atomic_load(&quitting) || !atomic_load(&has_session)) break;
+            close(socket_fd);
+            socket_fd = reconnect();
+            atomic_store(server_fd,socket_fd); // Closed by main once the threads ended
+            if(socket_fd == -1) break;
+            continue;
         }
         // Ensure that the commands end with \0. If chains contains \n replace this by \0.
         buffer[len] = '\0';
         printf("%s",buffer);
 
+        int token = parse_token(buffer,session_token,sizeof(session_token));
+        if(token == SESSION_MESSAGE){
+            atomic_store(&has_session,true);
+        } else if(token == RESUME_FAILED_MESSAGE){
+            atomic_store(&has_session,false); // The seat is lost, no more attempts
+        }
+
         // Si message fichier pdf disponible
         if(parse_stoc(buffer) == PDF_FILE_MESSAGE){
             pdfFile pdfi = parse_pdf(buffer);
             if(pdfi.filename){
-                download_pdf(pdfi.filename,s_port+1,s_ip);
+                if(queue_download(&downloader,pdfi.filename) == -1)
+                    printf("Trop de téléchargements en attente, %s est ignoré\n",pdfi.filename);
                 free(pdfi.filename); // Libérer la mémoire allouée
             } else {
                 printf("Erreur lors de l'analyse du message PDF\n");
@@ -119,32 +122,38 @@ void *handle_reader(void * args) {
         }
     }
     keepalive = false;
-    close(socket_fd);
     return NULL;
 }
 
 void *handle_sender(void * args) {
-    int socket_fd = *(int*)args;
+    atomic_int *server_fd = args;
 
     char buffer[BUFSIZ];
     while(keepalive){
         memset(buffer,0,sizeof(buffer));
-        scanf("%s",buffer);
+        if(scanf("%s",buffer) != 1) strcpy(buffer,"quit");
+        int socket_fd = atomic_load(server_fd);
 
         if(strcmp("help",buffer) == 0 ){
             print_file(HELP_FILE);
         } else if(strcmp("quit",buffer) == 0){
+            atomic_store(&quitting,true);
+            send(socket_fd,buffer,strlen(buffer),MSG_NOSIGNAL); // The server frees the seat at once
             shutdown(socket_fd,SHUT_RD);
             break;
         } else {
-            if(send(socket_fd,buffer,strlen(buffer),0) <= 0){
+            if(send(socket_fd,buffer,strlen(buffer),MSG_NOSIGNAL) <= 0){
+                if(atomic_load(&has_session) && keepalive){
+                    printf("Connexion perdue, commande ignorée.\n"); // The reader takes the seat back
+                    continue;
+                }
                 perror("ERROR sending message");
+                shutdown(socket_fd,SHUT_RDWR);
                 break;
             }
         }
     }
     keepalive = false;
-    close(socket_fd);
 
     return NULL;
 }
@@ -166,11 +175,15 @@ int main(int argc, char **argv) {
     printf("Tentative de connection avec le serveur %s %d ...\n",ip,port);
 
     int socket_fd = create_socket(ip,port);
-    int *socket = malloc(sizeof (int));
-    *socket = socket_fd;
+    atomic_int *socket = malloc(sizeof (atomic_int));
+    atomic_init(socket,socket_fd);
 
     printf("Connection avec le serveur établie !\n");
 
+    if(start_downloader(&downloader,ip,port + 1) == -1){
+        exit(EXIT_FAILURE);
+    }
+
 
     // Création des threads
     pthread_t pidReader;
@@ -196,8 +209,10 @@ int main(int argc, char **argv) {
         exit(EXIT_FAILURE);
     }
 
+    stop_downloader(&downloader);
+    socket_fd = atomic_load(socket); // Replaced by the reader after a reconnection
+    if(socket_fd >= 0) close(socket_fd);
     free(socket);
-    close(socket_fd);
 
     return 0;
 }
\ No newline at end of file
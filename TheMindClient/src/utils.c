@@ -48,13 +48,34 @@ void print_file(const char *filename) {
     fclose(file);  // Fermer le fichier
 }
 int parse_stoc(const char* msg){
-    const char* start_phrase = GRN"\nLe fichier de statistiques est disponible.";
-    if (strncmp(msg, start_phrase, strlen(start_phrase)) == 0) {
+    // The message may come with others in the same read, with or without colors.
+    if (strstr(msg, "Le fichier de statistiques est disponible.") != NULL) {
         return PDF_FILE_MESSAGE;
     }
     return -1;
 }
 
+/**
+ * @brief Look for the session token sent by the server, or the refusal of a resume.
+ * @param token Filled with the token when found.
+ * @return SESSION_MESSAGE, RESUME_FAILED_MESSAGE, or -1 if the message has none.
+ */
+int parse_token(const char* msg, char* token, size_t size){
+    const char* line = strstr(msg, "Jeton de session : ");
+    if (line != NULL) {
+        line += strlen("Jeton de session : ");
+        size_t len = strcspn(line, "\r\n");
+        if (len == 0 || len >= size) return -1;
+        memcpy(token, line, len);
+        token[len] = '\0';
+        return SESSION_MESSAGE;
+    }
+    if (strstr(msg, "Session inconnue ou expirée") != NULL) {
+        return RESUME_FAILED_MESSAGE;
+    }
+    return -1;
+}
+
 pdfFile parse_pdf(const char* msg){
     pdfFile pdf_fi;
     pdf_fi.filename = NULL;
@@ -93,8 +114,7 @@ pdfFile parse_pdf(const char* msg){
     }
 
     if (sscanf(port_line, "sur le port %d", &pdf_fi.port) != 1) {
-        printf("Erreur d'extraction du port\n");
-        return pdf_fi;
+        pdf_fi.port = 0; // "sur le port du serveur + 1" : the default download port
     }
 
     return pdf_fi;
@@ -8,6 +8,9 @@
 #include <sys/stat.h>
 
 #define PDF_FILE_MESSAGE 1
+#define SESSION_MESSAGE 2
+#define RESUME_FAILED_MESSAGE 3
+#define TOKEN_SIZE 64
 typedef struct {
     int port;
     char* filename;
@@ -18,6 +21,7 @@ void print_brain_art();
 void print_file(const char *filename);
 int parse_stoc(const char* msg);
 pdfFile parse_pdf(const char* msg);
+int parse_token(const char* msg, char* token, size_t size);
 void install();
 
 #endif //THEMINDCLIENT_UTILS_H
@@ -30,7 +30,6 @@ void free_GameState(GameState *gs) {
 
 void add_card(GameState *gs, int card) {
     enqueue(gs->cards,card);
-    sort_queue(gs->cards);
     if(card < gs->min_card){
         gs->min_card = card;
         gs->diff = gs->min_card;
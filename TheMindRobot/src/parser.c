@@ -6,51 +6,204 @@
 #include <malloc.h>
 #include "parser.h"
 
-void remove_ansi_codes(char *msg) {
-    char *src = msg, *dst = msg;
-    while (*src) {
-        if (*src == '\e') { // Début d'une séquence ANSI
-            src++;          // Ignorer '\e'
-            if (*src == '[') {
-                src++;      // Ignorer '['
-                while ((*src >= '0' && *src <= '9') || *src == ';') { // Ignorer chiffres et ';'
-                    src++;
+#define ANSI_TEXT 0
+#define ANSI_ESC 1 // '\e' read
+#define ANSI_CSI 2 // '\e[' read, waiting for the final letter
+
+// Length of a literal, known at compile time.
+#define LIT_LEN(s) (sizeof(s) - 1)
+#define HAS_PREFIX(p, len, lit) ((len) >= LIT_LEN(lit) && memcmp((p), (lit), LIT_LEN(lit)) == 0)
+#define IS_EXACTLY(p, len, lit) ((len) == LIT_LEN(lit) && memcmp((p), (lit), LIT_LEN(lit)) == 0)
+
+void rx_init(RxBuffer *rx) {
+    rx->len = 0;
+    rx->ansi_state = ANSI_TEXT;
+}
+
+/**
+ * @brief Read an integer at the start of p.
+ * @return Number of bytes read, 0 if there is no digit.
+ */
+static size_t read_int(const char *p, size_t len, int *out) {
+    size_t i = 0;
+    int sign = 1, value = 0;
+    if (i < len && p[i] == '-') {
+        sign = -1;
+        i++;
+    }
+    size_t digits = i;
+    while (i < len && p[i] >= '0' && p[i] <= '9') {
+        value = value * 10 + (p[i] - '0');
+        i++;
+    }
+    if (i == digits) return 0;
+    *out = sign * value;
+    return i;
+}
+
+/**
+ * @brief Classify one line, already free of ANSI codes and without its '\n'.
+ * @param line The line, not necessarily '\0' terminated.
+ * @param len Length of the line.
+ * @return The classified message, with code NULL_MSG if the line is not an event.
+ */
+ServerMsg parse_stoc(const char* line, size_t len){
+    ServerMsg sm = {NULL_MSG, NULL, 0, 0};
+    if (len == 0) return sm;
+
+    // Messages starting with a fixed text
+    switch (line[0]) {
+        case 'B':
+            if (HAS_PREFIX(line, len, "Bravo vous avez gagné la manche ")) {
+                size_t off = LIT_LEN("Bravo vous avez gagné la manche ");
+                if (read_int(line + off, len - off, &sm.param2)) sm.code = WIN_ROUND;
+                return sm;
+            }
+            break;
+        case 'L':
+            if (HAS_PREFIX(line, len, "La manche continue, dernière carte jouée : ")) {
+                size_t off = LIT_LEN("La manche continue, dernière carte jouée : ");
+                if (read_int(line + off, len - off, &sm.param2)) sm.code = RESUME_PLAY;
+                return sm;
+            }
+            if (HAS_PREFIX(line, len, "La manche ")) {
+                size_t off = LIT_LEN("La manche ");
+                size_t n = read_int(line + off, len - off, &sm.param2);
+                if (n && HAS_PREFIX(line + off + n, len - off - n, " est perdu !")) sm.code = LOOSE_ROUND;
+                return sm;
+            }
+            if (IS_EXACTLY(line, len, "La partie vas commencer dans : 3 2 1 Go !")) {
+                sm.code = GO;
+                return sm;
+            }
+            break;
+        case 'C':
+            if (HAS_PREFIX(line, len, "Carte : ")) {
+                size_t off = LIT_LEN("Carte : ");
+                if (read_int(line + off, len - off, &sm.param2)) sm.code = CARD;
+                return sm;
+            }
+            break;
+        case 'J':
+            if (HAS_PREFIX(line, len, "Jeton de session : ")) {
+                size_t off = LIT_LEN("Jeton de session : ");
+                if (len > off) {
+                    sm.code = SESSION;
+                    sm.param1 = line + off;
+                    sm.param1_len = (int)(len - off);
                 }
-                if (*src) src++; // Ignorer la lettre finale (par exemple 'm')
+                return sm;
             }
-        } else {
-            *dst++ = *src++; // Copier les caractères normaux
-        }
+            break;
+        case 'S':
+            if (HAS_PREFIX(line, len, "Session reprise à la table ")) {
+                sm.code = RESUMED;
+                return sm;
+            }
+            if (IS_EXACTLY(line, len, "Session inconnue ou expirée.")) {
+                sm.code = RESUME_FAILED;
+                return sm;
+            }
+            break;
+        case 'V':
+            if (HAS_PREFIX(line, len, "Vous êtes à la table ")) {
+                size_t off = LIT_LEN("Vous êtes à la table ");
+                if (read_int(line + off, len - off, &sm.param2)) sm.code = SEATED;
+                return sm;
+            }
+            break;
+        case 'P':
+            if (IS_EXACTLY(line, len, "Prêt pour une nouvelle partie ?")) {
+                sm.code = ENDGAME;
+                return sm;
+            }
+            break;
     }
-    *dst = '\0'; // Terminer la chaîne
-}
 
-ServerMsg parse_stoc(const char* msg){
-    ServerMsg sm;
-    sm.code = NULL_MSG;
-    int n = 0;
+    // Messages starting with a player name : "<name> <event>"
+    const char *space = memchr(line, ' ', len);
+    if (space == NULL || space == line || space - line > 49) return sm;
+    const char *rest = space;
+    size_t rest_len = len - (space - line);
+    size_t off;
 
-    if(sscanf(msg,"%49s a lancé le round (niveau :%d)",sm.param1,&sm.param2) == 2){
-        sm.code = ROUND_START;
-    } else if (sscanf(msg,"%49s -> %d",sm.param1,&sm.param2) == 2){
+    if (HAS_PREFIX(rest, rest_len, " -> ")) {
+        off = LIT_LEN(" -> ");
         sm.code = CARD_PLAY;
-    } else if (sscanf(msg,"Bravo vous avez gagné la manche %d",&sm.param2) == 1){
-        sm.code = WIN_ROUND;
-    } else if (sscanf(msg,"La manche %d est perdu !",&sm.param2) == 1){
-        sm.code = LOOSE_ROUND;
-    } else if (sscanf(msg,"Carte : %d",&sm.param2) == 1){
-        sm.code = CARD;
-    } else if (sscanf(msg,"%49s a lancé la partie ! (joueurs : %d)", sm.param1,&sm.param2) == 2 ){
+    } else if (HAS_PREFIX(rest, rest_len, " a lancé le round (niveau :")) {
+        off = LIT_LEN(" a lancé le round (niveau :");
+        sm.code = ROUND_START;
+    } else if (HAS_PREFIX(rest, rest_len, " a lancé la partie ! (joueurs : ")) {
+        off = LIT_LEN(" a lancé la partie ! (joueurs : ");
         sm.code = GAME_START;
-    } else if (strcmp("La partie vas commencer dans : 3 2 1 Go !",msg) == 0){
-        sm.code = GO;
-    } else if (strcmp("Prêt pour une nouvelle partie ?",msg) == 0) {
-        sm.code = ENDGAME;
     } else {
         return sm;
     }
-
-//    printf("{%s} parsed to : {%d}\n",msg,sm.code);
+    if (!read_int(rest + off, rest_len - off, &sm.param2)) {
+        sm.code = NULL_MSG;
+        return sm;
+    }
+    sm.param1 = line;
+    sm.param1_len = (int)(space - line);
     return sm;
 }
 
+/**
+ * @brief Parse the bytes just received at rx->data + rx->len.
+ *
+ * Single pass over the new bytes : ANSI sequences are skipped while the text is compacted
+ * in place, each '\n' frames a line which is classified and given to the handler.
+ * The unfinished last line is moved to the start of the buffer for the next reception.
+ *
+ * @param rx The receive buffer.
+ * @param received Number of bytes received at rx->data + rx->len.
+ * @param handler Called for every line classified as an event.
+ * @param ctx Passed to the handler.
+ * @return 0, or -1 if the handler stopped the parsing.
+ */
+int parse_received(RxBuffer *rx, size_t received, msg_handler handler, void *ctx) {
+    char *data = rx->data;
+    size_t src = rx->len, end = rx->len + received;
+    size_t dst = rx->len; // Write position of the cleaned text
+    size_t line_start = 0;
+    int state = rx->ansi_state;
+
+    while (src < end) {
+        char c = data[src++];
+        switch (state) {
+            case ANSI_ESC:
+                if (c == '[') {
+                    state = ANSI_CSI;
+                    continue;
+                }
+                state = ANSI_TEXT; // Lone '\e' : the character is kept
+                break;
+            case ANSI_CSI:
+                if ((c < '0' || c > '9') && c != ';') state = ANSI_TEXT; // Final letter
+                continue;
+        }
+
+        if (c == '\e') {
+            state = ANSI_ESC;
+        } else if (c == '\n') {
+            ServerMsg sm = parse_stoc(data + line_start, dst - line_start);
+            line_start = dst;
+            if (sm.code != NULL_MSG && handler(ctx, &sm) == -1) {
+                rx->len = 0;
+                rx->ansi_state = ANSI_TEXT;
+                return -1;
+            }
+        } else {
+            data[dst++] = c;
+        }
+    }
+
+    rx->ansi_state = state;
+    rx->len = dst - line_start;
+    if (rx->len == sizeof(rx->data)) {
+        rx->len = 0; // Line longer than the buffer, not an event : dropped
+    } else if (line_start > 0 && rx->len > 0) {
+        memmove(data, data + line_start, rx->len);
+    }
+    return 0;
+}
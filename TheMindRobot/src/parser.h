@@ -15,16 +15,46 @@
 #define CARD 105
 #define GO 106
 #define ENDGAME 107
+#define SESSION 108
+#define RESUMED 109
+#define RESUME_PLAY 110
+#define RESUME_FAILED 111
+#define SEATED 112
 
 #define NULL_MSG (-1)
 
+/**
+ * @brief A classified server line.
+ * @warning param1 points inside the receive buffer and is not '\0' terminated,
+ *          it is only valid during the handler call.
+ */
 typedef struct {
     int code;
-    char param1[50];
+    const char *param1; // Player name or session token, if any
+    int param1_len;
     int param2;
 } ServerMsg;
 
-ServerMsg parse_stoc(const char* msg);
-void remove_ansi_codes(char *msg);
+/**
+ * @brief Receive buffer of one connection.
+ *
+ * Bytes are received directly at data + len, then scanned once : ANSI sequences are
+ * dropped by compacting the buffer in place, and complete lines are classified where they lie.
+ * Only the unfinished tail line is kept between two receptions.
+ */
+typedef struct {
+    char data[BUFSIZ];
+    size_t len; // Bytes of the unfinished line, already cleaned
+    int ansi_state; // Position inside an ANSI sequence split between two receptions
+} RxBuffer;
+
+/**
+ * @brief Called for every classified line, return -1 to stop the parsing.
+ */
+typedef int (*msg_handler)(void *ctx, const ServerMsg *msg);
+
+void rx_init(RxBuffer *rx);
+ServerMsg parse_stoc(const char* line, size_t len);
+int parse_received(RxBuffer *rx, size_t received, msg_handler handler, void *ctx);
 
 #endif //THEMINDCLIENT_UTILS_H
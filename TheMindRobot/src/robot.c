@@ -4,31 +4,99 @@
 #include <arpa/inet.h>
 #include <string.h>
 #include <stdbool.h>
-#include <pthread.h>
 #include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <getopt.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/resource.h>
 #include "parser.h"
 #include "GameState.h"
 #include "../../src/queue.h"
 
-#define WAIT_DELTA 4
-#define MIN_WAIT 2
-
-bool keepalive = true;
-GameState *gs;
-pthread_mutex_t wait_mutex = PTHREAD_MUTEX_INITIALIZER;
-pthread_cond_t wait_cond = PTHREAD_COND_INITIALIZER;
-int waiting = 0;  // Flag pour vérifier si le thread est en attente
-bool autoplay = false;
-
-
-int create_socket(const char* ip, int port){
+#define WAIT_DELTA_MS 4000 // Delay added per "step" of distance between the last card and ours
+#define MIN_WAIT_MS 2000 // Delay before playing a card close to the last one
+#define RESTART_DELAY_MS 2000 // Delay before restarting a round in autoplay
+#define AUTOSTART_DELAY_MS 3000 // Delay before the first start in autoplay
+#define MAX_SEATS 16
+#define MAX_EVENTS 32
+#define TOKEN_SIZE 64
+#define RECONNECT_TRIES 10 // Attempts to take a seat back after a lost connection
+#define RECONNECT_DELAY_MS 1000
+
+#define ACTION_NONE 0
+#define ACTION_PLAY 1
+#define ACTION_START 2
+#define ACTION_RECONNECT 3
+
+/**
+ * @brief Aggregated latency measures, in nanoseconds.
+ */
+typedef struct {
+    unsigned long count;
+    unsigned long long total_ns;
+    unsigned long long max_ns;
+} LatencyStats;
+
+/**
+ * @brief One robot player, bound to its own server connection and timer.
+ *
+ * Every seat is driven by the single event loop of the process : the socket is
+ * watched for server messages, and the timerfd fires when the seat must act
+ * (play its lowest card, or restart a round in autoplay).
+ */
+typedef struct {
+    int socket_fd; // Connection with the server
+    int timer_fd; // Millisecond timer for the next action
+    char name[50];
+    GameState *gs; // What the seat knows about the current round
+    RxBuffer rx; // Bytes received from the server, unfinished line kept
+    int action; // Action done when the timer fires
+    bool committed; // The armed play must not be postponed by new events
+    struct timespec deadline; // Expected expiration of the timer
+    LatencyStats lateness; // Delay between the deadline and the real expiration
+    LatencyStats handling; // Time spent handling one readable event
+    unsigned long cards_played;
+    int table; // Table given by the server, -1 until seated
+    bool leader; // In charge of restarting rounds of its table in autoplay
+    bool alive;
+    int index; // Position in the seats, kept in the epoll data
+    char token[TOKEN_SIZE]; // Session token, to take the seat back after a lost connection
+    int reconnects; // Failed attempts since the connection was lost
+} Seat;
+
+/**
+ * @brief Tunable parameters of the robot, set from the command line.
+ */
+typedef struct {
+    int min_wait_ms;
+    int wait_delta_ms;
+    int restart_delay_ms;
+    bool autoplay;
+} RobotConfig;
+
+volatile sig_atomic_t keepalive = true;
+RobotConfig config = {MIN_WAIT_MS, WAIT_DELTA_MS, RESTART_DELAY_MS, false};
+const char *server_ip;
+int server_port;
+int epoll_fd;
+Seat *seats;
+int nb_seats = 1;
+
+/**
+ * @brief Connect to the server.
+ * @return The socket, or -1 on error.
+ */
+int connect_server(const char* ip, int port){
     int socket_fd;
     struct sockaddr_in server_addr;
 
     socket_fd = socket(PF_INET,SOCK_STREAM,0);
     if(socket_fd == -1){
         perror("ERROR creating socket\n");
-        exit(EXIT_FAILURE);
+        return -1;
     }
 
     memset(&server_addr,0,sizeof(server_addr));
@@ -36,229 +104,436 @@ int create_socket(const char* ip, int port){
     server_addr.sin_port = htons(port);
     if(inet_pton(AF_INET,ip,&server_addr.sin_addr) <= 0){
         perror("ERROR invalid ip address\n");
-        exit(EXIT_FAILURE);
+        close(socket_fd);
+        return -1;
     }
 
     if(connect(socket_fd,(struct sockaddr*)&server_addr,sizeof(server_addr)) == -1){
         perror("ERROR connecting to server\n");
-        exit(EXIT_FAILURE);
+        close(socket_fd);
+        return -1;
     }
     return socket_fd;
 }
 
-void wake_up_thread() {
-    pthread_mutex_lock(&wait_mutex);
-    if (waiting) {
-        pthread_cond_signal(&wait_cond);  // Réveille le thread en attente
-    }
-    pthread_mutex_unlock(&wait_mutex);
+int create_socket(const char* ip, int port){
+    int socket_fd = connect_server(ip,port);
+    if(socket_fd == -1) exit(EXIT_FAILURE);
+    return socket_fd;
 }
 
-void *handle_reader(void * args) {
-    int socket_fd = *(int*)args;
-    char partial_msg[BUFSIZ] = "";
-    size_t partial_len = 0;
-
-    char buffer[BUFSIZ];
-    while(keepalive){
-        memset(buffer,0,sizeof(buffer));
-        ssize_t len = recv(socket_fd,buffer,sizeof(buffer) - 1, 0);
-        if(len <= 0){
-            if(len == 0){
-                printf("Connection fermé par le serveur.\n");
-            } else {
-                perror("ERROR receiving message");
-            }
-            break;
-        }
-        // Ensure that the commands end with \0. If chains contains \n replace this by \0.
-        buffer[len] = '\0';
-        strncat(partial_msg,buffer,sizeof(partial_msg) - partial_len -1);
-        partial_len = strlen(partial_msg);
-        char *start = partial_msg;
-        char *newline = strchr(start,'\n');
-
-        while (newline){
-            *newline = '\0';
-            remove_ansi_codes(start);
-            ServerMsg serveur_msg = parse_stoc(start);
-            switch (serveur_msg.code) {
-                case GAME_START:
-                    gs->nb_p = serveur_msg.param2;
-                    break;
-                case ROUND_START:
-                    gs->round_lvl = serveur_msg.param2;
-                    break;
-                case CARD:
-                    add_card(gs,serveur_msg.param2);
-                    break;
-                case GO:
-                    gs->play = true;
-                    wake_up_thread();
-                    break;
-                case CARD_PLAY:
-                    gs->l_card = serveur_msg.param2;
-                    gs->diff = gs->min_card - gs->l_card;
-                    wake_up_thread();
-                    break;
-                case LOOSE_ROUND:
-                    reset(gs);
-                    if(autoplay){
-                        sleep(2);
-                        send(socket_fd,"start",sizeof("start"),0);
-                    }
-                    break;
-                case WIN_ROUND:
-                    reset(gs);
-                    if(autoplay){
-                        sleep(2);
-                        send(socket_fd,"start",sizeof("start"),0);
-                    }
-                    break;
-                case ENDGAME:
-                    keepalive = false;
-                    wake_up_thread();
-                    break;
-            }
+/**
+ * @brief Watch the socket of a seat, the seat index is kept in the upper bits of the epoll data.
+ */
+static void watch_socket(Seat *s){
+    struct epoll_event ev = {.events = EPOLLIN};
+    ev.data.u64 = (uint64_t)s->index << 1;
+    epoll_ctl(epoll_fd,EPOLL_CTL_ADD,s->socket_fd,&ev);
+}
 
-            start = newline + 1;
-            newline = strchr(start,'\n');
+void handle_sigint(int sig) {
+    keepalive = false;
+}
 
-        }
+static unsigned long long elapsed_ns(const struct timespec *from, const struct timespec *to){
+    long long ns = (long long)(to->tv_sec - from->tv_sec) * 1000000000LL + (to->tv_nsec - from->tv_nsec);
+    return ns < 0 ? 0 : (unsigned long long)ns;
+}
 
-        if(*start != '\0') {
-            memmove(partial_msg,start,strlen(start) + 1);
-        } else {
-            partial_msg[0] = '\0';
+static void record_latency(LatencyStats *ls, unsigned long long ns){
+    ls->count++;
+    ls->total_ns += ns;
+    if(ns > ls->max_ns) ls->max_ns = ns;
+}
+
+/**
+ * @brief Arm the seat timer to fire in delay_ms milliseconds.
+ * @param s The seat.
+ * @param action Action to do when the timer fires, ACTION_NONE disarm the timer.
+ * @param delay_ms Delay in milliseconds.
+ */
+void arm_timer(Seat *s, int action, int delay_ms){
+    struct itimerspec its = {0};
+    s->action = action;
+    if(action != ACTION_NONE){
+        if(delay_ms < 1) delay_ms = 1; // A zero it_value would disarm the timer
+        its.it_value.tv_sec = delay_ms / 1000;
+        its.it_value.tv_nsec = (long)(delay_ms % 1000) * 1000000L;
+        clock_gettime(CLOCK_MONOTONIC,&s->deadline);
+        s->deadline.tv_sec += its.it_value.tv_sec;
+        s->deadline.tv_nsec += its.it_value.tv_nsec;
+        if(s->deadline.tv_nsec >= 1000000000L){
+            s->deadline.tv_sec++;
+            s->deadline.tv_nsec -= 1000000000L;
         }
     }
-    keepalive = false;
-    close(socket_fd);
-    return NULL;
+    if(timerfd_settime(s->timer_fd,0,&its,NULL) == -1){
+        perror("ERROR arming timer");
+    }
 }
 
-void *handle_sender(void * args) {
-    int socket_fd = *(int*)args;
-    char buffer[BUFSIZ];
-
-    while(keepalive){
-        while(gs->play == false || isEmpty(gs->cards) == true){
-            pthread_mutex_lock(&wait_mutex);
-            waiting = 1;
-            pthread_cond_wait(&wait_cond,&wait_mutex);
-            waiting = 0;
-            pthread_mutex_unlock(&wait_mutex);
+/**
+ * @brief Decide when the seat should play its lowest card.
+ *
+ * The further our lowest card is from the last played card, the longer we wait.
+ * Each new event re-evaluates the decision, except once a close card is committed.
+ * @param s The seat.
+ */
+void schedule_play(Seat *s){
+    GameState *gs = s->gs;
+    if(gs->play == false || isEmpty(gs->cards)){
+        if(s->action == ACTION_PLAY){
+            arm_timer(s,ACTION_NONE,0);
         }
+        s->committed = false;
+        return;
+    }
+    if(s->action == ACTION_PLAY && s->committed) return;
 
-        memset(buffer,0,sizeof(buffer));
-        int diff_p = 99 / (gs->round_lvl * gs->nb_p);
-        if(gs->diff < diff_p){
+    int diff_p = (gs->round_lvl > 0 && gs->nb_p > 0) ? 99 / (gs->round_lvl * gs->nb_p) : 1;
+    if(diff_p < 1) diff_p = 1;
 
-            sleep(MIN_WAIT);
-            snprintf(buffer,sizeof(buffer),"%d",gs->min_card);
-            if(play_card(gs) == -1){
-                continue;
-            }
-            if(send(socket_fd,buffer,strlen(buffer),0) <= 0){
-                perror("ERROR sending message");
-                break;
-            }
+    if(gs->diff < diff_p){
+        s->committed = true;
+        arm_timer(s,ACTION_PLAY,config.min_wait_ms);
+    } else {
+        s->committed = false;
+        arm_timer(s,ACTION_PLAY,(gs->diff / diff_p) * config.wait_delta_ms);
+    }
+}
 
-        } else {
-            int wait_time = ( gs->diff / diff_p ) * WAIT_DELTA;
+/**
+ * @brief Seat seated at a table : the first seat of the process at this table leads it.
+ *
+ * The leader starts the first round in autoplay, then restarts the rounds of its table.
+ */
+static void elect_leader(Seat *s, int table){
+    s->table = table;
+    for (int i = 0; i < nb_seats; ++i) {
+        if(seats[i].alive && seats[i].leader && seats[i].table == table) return;
+    }
+    s->leader = true;
+    if(config.autoplay){
+        arm_timer(s,ACTION_START,AUTOSTART_DELAY_MS);
+    }
+}
 
-            pthread_mutex_lock(&wait_mutex);
-            waiting = 1;
+void close_seat(Seat *s){
+    if(!s->alive) return;
+    s->alive = false;
+    if(s->socket_fd >= 0) close(s->socket_fd);
+    close(s->timer_fd);
+    if(!s->leader) return;
+    s->leader = false;
+    for (int i = 0; i < nb_seats; ++i) { // Another seat of the table takes the lead
+        if(seats[i].alive && seats[i].table == s->table){
+            seats[i].leader = true;
+            return;
+        }
+    }
+}
 
-            struct timespec ts;
-            clock_gettime(CLOCK_REALTIME,&ts);
-            ts.tv_sec += wait_time;
+/**
+ * @brief The connection of a seat is lost : its cards are kept by the server, retry with the token.
+ *
+ * The attempts are driven by the seat timer, so that the other seats keep playing.
+ */
+static void lose_connection(Seat *s){
+    close(s->socket_fd); // Also removed from epoll
+    s->socket_fd = -1;
+    s->reconnects = 0;
+    s->committed = false;
+    arm_timer(s,ACTION_RECONNECT,RECONNECT_DELAY_MS);
+}
 
-            int ret = pthread_cond_timedwait(&wait_cond,&wait_mutex, &ts);
+/**
+ * @brief Reconnect a seat and ask for its held seat.
+ */
+static void reconnect_seat(Seat *s){
+    s->socket_fd = connect_server(server_ip,server_port);
+    if(s->socket_fd == -1){
+        if(++s->reconnects < RECONNECT_TRIES){
+            arm_timer(s,ACTION_RECONNECT,RECONNECT_DELAY_MS);
+        } else {
+            close_seat(s);
+        }
+        return;
+    }
+    rx_init(&s->rx);
+    watch_socket(s);
+    char msg[TOKEN_SIZE + 16];
+    snprintf(msg,sizeof(msg),"resume %s\n",s->token);
+    if(send(s->socket_fd,msg,strlen(msg),0) <= 0){
+        perror("ERROR sending message");
+        close_seat(s);
+    }
+}
 
-            if(ret == 0) { // Thread réveillé par un autre thread
-                waiting = 0;
-                pthread_mutex_unlock(&wait_mutex);
+/**
+ * @brief Handle one event received from the server.
+ * @param ctx The seat receiving the event.
+ * @param msg The classified server line.
+ * @return 0 to continue the parsing, -1 if the seat is closed.
+ */
+int handle_msg(void *ctx, const ServerMsg *msg){
+    Seat *s = ctx;
+    GameState *gs = s->gs;
+    switch (msg->code) {
+        case GAME_START:
+            gs->nb_p = msg->param2;
+            break;
+        case ROUND_START:
+            gs->round_lvl = msg->param2;
+            break;
+        case CARD:
+            add_card(gs,msg->param2);
+            break;
+        case GO:
+            gs->play = true;
+            schedule_play(s);
+            break;
+        case CARD_PLAY:
+            gs->l_card = msg->param2;
+            gs->diff = gs->min_card - gs->l_card;
+            schedule_play(s);
+            break;
+        case LOOSE_ROUND:
+        case WIN_ROUND:
+            reset(gs);
+            s->committed = false;
+            if(config.autoplay && s->leader){
+                arm_timer(s,ACTION_START,config.restart_delay_ms);
             } else {
-                waiting = 0;
-                pthread_mutex_unlock(&wait_mutex);
-
-                if(gs->play == false || isEmpty(gs->cards) == true) continue;
-
-                snprintf(buffer,sizeof(buffer),"%d",gs->min_card); // Joué la carte
-                play_card(gs);
-                if(send(socket_fd,buffer,strlen(buffer),0) <= 0){
-                    perror("ERROR sending message");
-                    break;
-                }
+                arm_timer(s,ACTION_NONE,0);
+            }
+            break;
+        case SEATED:
+            elect_leader(s,msg->param2);
+            break;
+        case SESSION:
+            if(msg->param1_len < TOKEN_SIZE){
+                memcpy(s->token,msg->param1,msg->param1_len);
+                s->token[msg->param1_len] = '\0';
             }
+            break;
+        case RESUMED:
+            printf("[%s] Place reprise.\n",s->name);
+            reset(gs); // The hand is sent again
+            s->committed = false;
+            arm_timer(s,ACTION_NONE,0);
+            break;
+        case RESUME_PLAY:
+            gs->l_card = msg->param2;
+            gs->diff = gs->min_card - gs->l_card;
+            gs->play = true;
+            schedule_play(s);
+            break;
+        case RESUME_FAILED:
+        case ENDGAME:
+            close_seat(s);
+            return -1;
+    }
+    return 0;
+}
 
+/**
+ * @brief Receive on the socket of a seat and handle every complete line.
+ * @param s The seat.
+ */
+void on_readable(Seat *s){
+    struct timespec begin, end;
+
+    ssize_t len = recv(s->socket_fd,s->rx.data + s->rx.len,sizeof(s->rx.data) - s->rx.len, 0);
+    clock_gettime(CLOCK_MONOTONIC,&begin);
+    if(len <= 0){
+        if(len == 0){
+            printf("[%s] Connection fermé par le serveur.\n",s->name);
+        } else {
+            perror("ERROR receiving message");
         }
-
+        if(keepalive && s->token[0] != '\0'){
+            lose_connection(s);
+        } else {
+            close_seat(s);
+        }
+        return;
     }
-    keepalive = false;
-    close(socket_fd);
+    if(parse_received(&s->rx,(size_t)len,handle_msg,s) == -1) return;
 
-    return NULL;
+    clock_gettime(CLOCK_MONOTONIC,&end);
+    record_latency(&s->handling,elapsed_ns(&begin,&end));
 }
 
-int main(int argc, char **argv) {
-    if(argc != 5){
-        fprintf(stderr,"Usage : %s <port> <ipv4> <robotName> <autostart 0|1>\n",argv[0]);
-        exit(EXIT_FAILURE);
+/**
+ * @brief Do the pending action of a seat when its timer fires.
+ * @param s The seat.
+ */
+void on_timer(Seat *s){
+    uint64_t expirations;
+    struct timespec now;
+    if(read(s->timer_fd,&expirations,sizeof(expirations)) != sizeof(expirations)) return;
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    record_latency(&s->lateness,elapsed_ns(&s->deadline,&now));
+
+    int action = s->action;
+    s->action = ACTION_NONE;
+    s->committed = false;
+    char buffer[16];
+
+    if(action == ACTION_RECONNECT){
+        reconnect_seat(s);
+        return;
     }
-    int port = atoi(argv[1]);
-    char *ip = argv[2];
-    char *name = argv[3];
-    int start = atoi(argv[4]);
-    if(start == 1){
-        autoplay = true;
+    if(s->socket_fd == -1) return; // Waiting for a reconnection
+    if(action == ACTION_START){
+        if(send(s->socket_fd,"start",strlen("start"),0) <= 0){
+            perror("ERROR sending message");
+            close_seat(s);
+        }
+    } else if(action == ACTION_PLAY){
+        if(s->gs->play == false || isEmpty(s->gs->cards)) return;
+        snprintf(buffer,sizeof(buffer),"%d",s->gs->min_card);
+        if(play_card(s->gs) == -1) return;
+        if(send(s->socket_fd,buffer,strlen(buffer),0) <= 0){
+            perror("ERROR sending message");
+            close_seat(s);
+            return;
+        }
+        s->cards_played++;
+        schedule_play(s); // Next card, if any
     }
-    // Set les variables global.
-
-    printf("Tentative de connection avec le serveur %s %d ...\n",ip,port);
-
-    int socket_fd = create_socket(ip,port);
-    int *socket = malloc(sizeof (int));
-    *socket = socket_fd;
-
-    printf("Connection avec le serveur établie !\n");
-    gs = create_gameState();
-
-    send(socket_fd,name,sizeof(name),0);
+}
 
-    // Création des threads
-    pthread_t pidReader;
-    if(pthread_create(&pidReader,NULL,handle_reader,socket) !=0){
-        perror("ERROR : reader thread creation");
-        exit(EXIT_FAILURE);
+void print_report(Seat *seats, int nb_seats){
+    struct rusage ru;
+    getrusage(RUSAGE_SELF,&ru);
+    printf("------ Robot : mesures ------\n");
+    for (int i = 0; i < nb_seats; ++i) {
+        Seat *s = &seats[i];
+        printf("%s : cartes %lu | retard timer moy %.1f us max %.1f us | traitement moy %.1f us max %.1f us\n",
+               s->name,s->cards_played,
+               s->lateness.count ? s->lateness.total_ns / 1000.0 / s->lateness.count : 0.0,
+               s->lateness.max_ns / 1000.0,
+               s->handling.count ? s->handling.total_ns / 1000.0 / s->handling.count : 0.0,
+               s->handling.max_ns / 1000.0);
     }
+    printf("CPU : user %ld.%06lds sys %ld.%06lds\n",
+           (long)ru.ru_utime.tv_sec,(long)ru.ru_utime.tv_usec,(long)ru.ru_stime.tv_sec,(long)ru.ru_stime.tv_usec);
+    printf("-----------------------------\n");
+}
 
-    pthread_t pidWriter;
-    if(pthread_create(&pidWriter,NULL,handle_sender,socket) !=0){
-        perror("ERROR : sender thread creation");
+int main(int argc, char **argv) {
+    int table = -1;
+    bool report = false;
+    int opt;
+    while((opt = getopt(argc,argv,"n:t:w:d:r:v")) != -1){
+        switch (opt) {
+            case 'n': nb_seats = atoi(optarg); break;
+            case 't': table = atoi(optarg); break;
+            case 'w': config.min_wait_ms = atoi(optarg); break;
+            case 'd': config.wait_delta_ms = atoi(optarg); break;
+            case 'r': config.restart_delay_ms = atoi(optarg); break;
+            case 'v': report = true; break;
+            default: nb_seats = -1;
+        }
+    }
+    if(argc - optind != 4 || nb_seats < 1 || nb_seats > MAX_SEATS){
+        fprintf(stderr,"Usage : %s [-n seats] [-t table] [-w min_wait_ms] [-d wait_delta_ms] [-r restart_ms] [-v] <port> <ipv4> <robotName> <autostart 0|1>\n",argv[0]);
         exit(EXIT_FAILURE);
     }
-
-    if(autoplay){
-        sleep(3);
-        send(socket_fd,"start",sizeof("start"),0);
+    int port = atoi(argv[optind]);
+    char *ip = argv[optind + 1];
+    char *name = argv[optind + 2];
+    config.autoplay = atoi(argv[optind + 3]) == 1;
+
+    signal(SIGINT,handle_sigint);
+    signal(SIGPIPE,SIG_IGN);
+    server_ip = ip;
+    server_port = port;
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if(epoll_fd == -1){
+        perror("ERROR : epoll creation");
+        exit(EXIT_FAILURE);
     }
 
-    // Attendre la fin des threads
-    if (pthread_join(pidReader, NULL) != 0) {
-        perror("ERROR : reader thread join");
+    seats = calloc(nb_seats,sizeof(Seat));
+    if(seats == NULL){
+        perror("ERROR : seats allocation");
         exit(EXIT_FAILURE);
     }
 
-    if (pthread_join(pidWriter, NULL) != 0) {
-        perror("ERROR : writer thread join");
-        exit(EXIT_FAILURE);
+    printf("Tentative de connection avec le serveur %s %d ...\n",ip,port);
+    for (int i = 0; i < nb_seats; ++i) {
+        Seat *s = &seats[i];
+        if(nb_seats == 1){
+            snprintf(s->name,sizeof(s->name),"%s",name);
+        } else {
+            snprintf(s->name,sizeof(s->name),"%s_%d",name,i);
+        }
+        s->socket_fd = create_socket(ip,port);
+        s->timer_fd = timerfd_create(CLOCK_MONOTONIC,TFD_NONBLOCK | TFD_CLOEXEC);
+        if(s->timer_fd == -1){
+            perror("ERROR : timer creation");
+            exit(EXIT_FAILURE);
+        }
+        s->gs = create_gameState();
+        rx_init(&s->rx);
+        s->table = -1;
+        s->leader = false;
+        s->alive = true;
+        s->index = i;
+
+        // The seat index is kept in the upper bits, the lowest bit tells socket from timer.
+        watch_socket(s);
+        struct epoll_event ev = {.events = EPOLLIN};
+        ev.data.u64 = ((uint64_t)i << 1) | 1;
+        epoll_ctl(epoll_fd,EPOLL_CTL_ADD,s->timer_fd,&ev);
+
+        // The first line names the seat, and asks for a given table if any.
+        char hello[64];
+        if(table >= 0){
+            snprintf(hello,sizeof(hello),"%s @%d",s->name,table);
+        } else {
+            snprintf(hello,sizeof(hello),"%s",s->name);
+        }
+        send(s->socket_fd,hello,strlen(hello),0);
+    }
+    printf("Connection avec le serveur établie ! (%d siège(s))\n",nb_seats);
+
+    int alive = nb_seats;
+    struct epoll_event events[MAX_EVENTS];
+    while(keepalive && alive > 0){
+        int n = epoll_wait(epoll_fd,events,MAX_EVENTS,-1);
+        if(n == -1){
+            if(errno == EINTR) continue;
+            perror("ERROR : epoll wait");
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            Seat *s = &seats[events[i].data.u64 >> 1];
+            if(!s->alive) continue;
+            if(events[i].data.u64 & 1){
+                on_timer(s);
+            } else {
+                on_readable(s);
+            }
+        }
+        alive = 0;
+        for (int i = 0; i < nb_seats; ++i) {
+            if(seats[i].alive) alive++;
+        }
     }
 
-    free_GameState(gs);
-    free(socket);
-    close(socket_fd);
+    if(report){
+        print_report(seats,nb_seats);
+    }
+    for (int i = 0; i < nb_seats; ++i) {
+        close_seat(&seats[i]);
+        free_GameState(seats[i].gs);
+    }
+    free(seats);
+    close(epoll_fd);
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,523 @@
+//
+// Created by erwan on 19/10/2026.
+//
+// Microbenchmarks of the server hot functions.
+// Each result is written as one JSON line : name, iterations, ns/op, allocations/op and bytes/op.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include "../src/Game.h"
+
+#define DEFAULT_MIN_TIME_MS 200
+#define MAX_PEERS 256
+
+/*
+ * Allocation counting, the target is linked with -Wl,--wrap=malloc,...
+ */
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static _Thread_local bool counting = false;
+static unsigned long long alloc_count = 0;
+static unsigned long long alloc_bytes = 0;
+
+void *__wrap_malloc(size_t size) {
+    if (counting) {
+        alloc_count++;
+        alloc_bytes += size;
+    }
+    return __real_malloc(size);
+}
+void *__wrap_calloc(size_t nmemb, size_t size) {
+    if (counting) {
+        alloc_count++;
+        alloc_bytes += nmemb * size;
+    }
+    return __real_calloc(nmemb, size);
+}
+void *__wrap_realloc(void *ptr, size_t size) {
+    if (counting) {
+        alloc_count++;
+        alloc_bytes += size;
+    }
+    return __real_realloc(ptr, size);
+}
+void __wrap_free(void *ptr) {
+    __real_free(ptr);
+}
+
+/*
+ * Timing harness
+ */
+typedef struct {
+    const char *name;
+    void (*setup)(void);
+    void (*run)(long iterations);
+    void (*teardown)(void);
+} Bench;
+
+static struct timespec pause_start;
+static unsigned long long paused_ns = 0;
+
+static unsigned long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief Exclude what follows (time and allocations) from the measure, until bench_resume.
+ */
+static void bench_pause(void) {
+    counting = false;
+    clock_gettime(CLOCK_MONOTONIC, &pause_start);
+}
+
+static void bench_resume(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    paused_ns += (ts.tv_sec - pause_start.tv_sec) * 1000000000ULL + ts.tv_nsec - pause_start.tv_nsec;
+    counting = true;
+}
+
+/**
+ * @brief Run a benchmark, growing the iteration count until it lasts at least min_time_ms.
+ */
+static void bench_run(const Bench *b, long min_time_ms, FILE *out) {
+    long iterations = 1;
+    unsigned long long elapsed;
+    if (b->setup) b->setup();
+    for (;;) {
+        alloc_count = 0;
+        alloc_bytes = 0;
+        paused_ns = 0;
+        unsigned long long start = now_ns();
+        counting = true;
+        b->run(iterations);
+        counting = false;
+        elapsed = now_ns() - start - paused_ns;
+        if (elapsed >= (unsigned long long)min_time_ms * 1000000ULL || iterations >= (1L << 30)) break;
+        // Aim 20% above the min time, never grow more than x100 at once.
+        double scale = elapsed > 0 ? (min_time_ms * 1.2e6) / (double)elapsed : 100.0;
+        if (scale > 100.0) scale = 100.0;
+        if (scale < 2.0) scale = 2.0;
+        iterations = (long)(iterations * scale);
+    }
+    if (b->teardown) b->teardown();
+
+    fprintf(out, "{\"bench\":\"%s\",\"iterations\":%ld,\"ns_per_op\":%.2f,\"allocs_per_op\":%.3f,\"bytes_per_op\":%.1f}\n",
+            b->name, iterations, (double)elapsed / iterations, (double)alloc_count / iterations,
+            (double)alloc_bytes / iterations);
+    fflush(out);
+}
+
+/*
+ * Socket peers : every player socket is one end of a socketpair, the other end is drained by a thread.
+ */
+static int peers[MAX_PEERS];
+static int peer_count = 0;
+static int drain_epoll = -1;
+static volatile bool draining = true;
+
+static void *drain_peers(void *arg) {
+    char buffer[BUFSIZ];
+    struct epoll_event events[32];
+    while (draining) {
+        int n = epoll_wait(drain_epoll, events, 32, 50);
+        for (int i = 0; i < n; ++i) {
+            while (read(events[i].data.fd, buffer, sizeof(buffer)) > 0);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Create a socketpair, return the server side and drain the client side.
+ */
+static int new_peer(void) {
+    int sv[2];
+    if (peer_count >= MAX_PEERS || socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) {
+        perror("ERROR socketpair");
+        exit(EXIT_FAILURE);
+    }
+    fcntl(sv[1], F_SETFL, O_NONBLOCK);
+    struct epoll_event ev = {.events = EPOLLIN, .data.fd = sv[1]};
+    epoll_ctl(drain_epoll, EPOLL_CTL_ADD, sv[1], &ev);
+    peers[peer_count++] = sv[1];
+    return sv[0];
+}
+
+static void close_peers(PlayerList *pl) {
+    int slot;
+    PlayerSnapshot *snap = read_players(pl, &slot);
+    for (int i = 0; i < snap->count; ++i) {
+        close(snap->players[i]->socket_fd);
+    }
+    release_players(pl, slot);
+    for (int i = 0; i < peer_count; ++i) {
+        close(peers[i]); // Also removed from the epoll set
+    }
+    peer_count = 0;
+}
+
+static PlayerList *make_players(int n) {
+    PlayerList *pl = init_pl(n);
+    for (int i = 0; i < n; ++i) {
+        Player *p = create_player(pl, new_peer());
+        snprintf(p->name, sizeof(p->name), "Joueur%d", i);
+    }
+    return pl;
+}
+
+static void free_players(PlayerList *pl) {
+    close_peers(pl);
+    free_players_card(pl);
+    while (pl->count > 0) {
+        remove_player(pl, atomic_load(&pl->snapshot)->players[pl->count - 1]);
+    }
+    free_player_list(pl);
+}
+
+static volatile long sink = 0;
+
+/*
+ * hash_cmd / ctoint dispatch
+ */
+static const char *commands[] = {"ready", "unready", "start", "stop", "add robot", "42", "quit", "hello"};
+
+static void run_hash_cmd(long n) {
+    long acc = 0;
+    for (long i = 0; i < n; ++i) {
+        const char *cmd = commands[i & 7];
+        int code = hash_cmd(cmd);
+        if (code == CARD) code += ctoint(cmd);
+        acc += code;
+    }
+    sink = acc;
+}
+
+/*
+ * format_board
+ */
+static int board[40];
+
+static void setup_board(void) {
+    for (int i = 0; i < 40; ++i) {
+        board[i] = i < 20 ? i * 4 + 3 : 0; // Half played board
+    }
+}
+
+static void run_format_board(long n) {
+    char msg[256];
+    StrBuilder sb;
+    for (long i = 0; i < n; ++i) {
+        sb_init(&sb, msg, sizeof(msg));
+        format_board(&sb, board, 40);
+        sink += msg[1];
+    }
+}
+
+/*
+ * Queue : enqueue / dequeue, a whole hand dealt then played
+ */
+static Queue *queue;
+
+static void setup_queue(void) {
+    queue = create_queue();
+}
+
+static void teardown_queue(void) {
+    destroy_queue(queue);
+}
+
+static void run_enqueue_dequeue(long n) {
+    for (long i = 0; i < n; ++i) {
+        enqueue(queue, (int)(i % 99) + 1);
+        sink += dequeue(queue);
+    }
+}
+
+static void run_fill_queue_40(long n) {
+    for (long i = 0; i < n; ++i) {
+        for (int j = 0; j < 40; ++j) {
+            enqueue(queue, (j * 37) % 99 + 1);
+        }
+        while (!isEmpty(queue)) {
+            sink += dequeue(queue);
+        }
+    }
+}
+
+/*
+ * Game functions : distribute_card, play_card, renderers, broadcast
+ */
+static Game *game;
+
+static void setup_game(int players, int round, int state) {
+    srand(42); // Same decks on every run
+    game = create_game(make_players(players));
+    game->gameData = create_gm();
+    game->gameData->player_count = players;
+    game->round = round;
+    game->state = state;
+}
+
+static void teardown_game(void) {
+    PlayerList *pl = game->playerList;
+    free_gm(game->gameData);
+    game->gameData = NULL;
+    free_game(game);
+    free_players(pl);
+}
+
+/**
+ * @brief Deal a new round without the countdown of start_round.
+ */
+static void deal_round(void) {
+    PlayerList *pl = game->playerList;
+    free_players_card(pl);
+    memset(game->owner, 0, sizeof(game->owner));
+    reset_queue(game->cards_queue);
+    memset(game->board, 0, sizeof(game->board));
+    game->played_cards_count = 0;
+    game->state = PLAY_STATE;
+    init_player_card(pl);
+    distribute_card(game);
+    game->start_ns = trace_now();
+}
+
+static void setup_distribute(void) {
+    setup_game(4, 10, PLAY_STATE);
+}
+
+static void run_distribute_card(long n) {
+    PlayerList *pl = game->playerList;
+    for (long i = 0; i < n; ++i) {
+        bench_pause();
+        free_players_card(pl);
+        reset_queue(game->cards_queue);
+        bench_resume();
+        init_player_card(pl);
+        distribute_card(game);
+    }
+}
+
+static void setup_play(void) {
+    setup_game(4, 24, PLAY_STATE);
+    deal_round();
+}
+
+static void run_play_card(long n) {
+    for (long i = 0; i < n; ++i) {
+        if (game->state != PLAY_STATE) {
+            bench_pause();
+            game->round = 24;
+            deal_round();
+            bench_resume();
+        }
+        int card = peek(game->cards_queue);
+        sink += play_card(game, game->owner[card], card);
+    }
+}
+
+static void setup_lobby(void) {
+    setup_game(4, 1, LOBBY_STATE);
+}
+
+static void run_print_lobbyState(long n) {
+    for (long i = 0; i < n; ++i) {
+        print_lobbyState(game);
+    }
+}
+
+static void setup_gameState(void) {
+    setup_game(4, 3, GAME_STATE);
+}
+
+static void run_print_gameState(long n) {
+    for (long i = 0; i < n; ++i) {
+        print_gameState(game);
+    }
+}
+
+static void setup_playState(void) {
+    setup_game(4, 10, PLAY_STATE);
+    deal_round();
+    for (int i = 0; i < 20; ++i) { // Half of the board played
+        game->board[game->played_cards_count++] = dequeue(game->cards_queue);
+    }
+}
+
+static void run_print_playState(long n) {
+    for (long i = 0; i < n; ++i) {
+        print_playState(game, false);
+    }
+}
+
+static void setup_playDelta(void) {
+    setup_playState();
+    for (int i = 0; i < game->playerList->count; ++i) {
+        atomic_load(&game->playerList->snapshot)->players[i]->delta = true;
+    }
+}
+
+static void run_print_playDelta(long n) {
+    Player *p = atomic_load(&game->playerList->snapshot)->players[0];
+    for (long i = 0; i < n; ++i) {
+        print_playState(game, false);
+        print_playDelta(game, p, game->board[19], 19);
+    }
+}
+
+/*
+ * Reaction time histograms
+ */
+static Histogram hists[2];
+
+static void run_hist_record(long n) {
+    uint64_t value = 1;
+    for (long i = 0; i < n; ++i) {
+        value = value * 6364136223846793005ULL + 1442695040888963407ULL; // LCG
+        hist_record(&hists[0], value >> 30); // Up to ~17 s
+    }
+}
+
+static void setup_hist(void) {
+    hist_reset(&hists[0]);
+    hist_reset(&hists[1]);
+    run_hist_record(1000);
+}
+
+static void run_hist_merge_p99(long n) {
+    for (long i = 0; i < n; ++i) {
+        hist_merge(&hists[1], &hists[0]);
+        sink += (long)hist_percentile(&hists[1], 99);
+    }
+}
+
+static void run_analytics_card(long n) {
+    for (long i = 0; i < n; ++i) {
+        analytics_card((int)(i % 99) + 1);
+    }
+}
+
+static PlayerList *fanout;
+
+static void setup_fanout(int n) {
+    fanout = make_players(n);
+}
+
+static void setup_fanout_4(void) { setup_fanout(4); }
+static void setup_fanout_16(void) { setup_fanout(16); }
+static void setup_fanout_64(void) { setup_fanout(64); }
+
+static void teardown_fanout(void) {
+    free_players(fanout);
+}
+
+static void run_broadcast(long n) {
+    for (long i = 0; i < n; ++i) {
+        broadcast_message(fanout, NULL, 0, "\n%s -> %d\n\n", "Joueur0", (int)(i % 99) + 1);
+    }
+}
+
+static void run_broadcast_msg(long n) {
+    for (long i = 0; i < n; ++i) {
+        broadcast_msg(fanout, NULL, 0, MSG_PLAY, MSG_ARGS(ARG_S("Joueur0"), ARG_D((int)(i % 99) + 1)));
+    }
+}
+
+/*
+ * Lobby churn : a player joins a table of 3 and leaves
+ */
+static void setup_churn(void) {
+    fanout = init_pl(4);
+    for (int i = 0; i < 3; ++i) {
+        create_player(fanout, -1);
+    }
+}
+
+static void run_lobby_churn(long n) {
+    for (long i = 0; i < n; ++i) {
+        Player *p = create_player(fanout, -1);
+        sink += p->id;
+        remove_player(fanout, p);
+    }
+}
+
+static const Bench benches[] = {
+        {"hash_cmd_dispatch", NULL, run_hash_cmd, NULL},
+        {"format_board_40", setup_board, run_format_board, NULL},
+        {"enqueue_dequeue", setup_queue, run_enqueue_dequeue, teardown_queue},
+        {"fill_queue_40", setup_queue, run_fill_queue_40, teardown_queue},
+        {"distribute_card_4p_r10", setup_distribute, run_distribute_card, teardown_game},
+        {"play_card_4p_r24", setup_play, run_play_card, teardown_game},
+        {"broadcast_message_4", setup_fanout_4, run_broadcast, teardown_fanout},
+        {"broadcast_message_16", setup_fanout_16, run_broadcast, teardown_fanout},
+        {"broadcast_message_64", setup_fanout_64, run_broadcast, teardown_fanout},
+        {"broadcast_msg_16", setup_fanout_16, run_broadcast_msg, teardown_fanout},
+        {"lobby_churn_4", setup_churn, run_lobby_churn, teardown_fanout},
+        {"print_lobbyState_4p", setup_lobby, run_print_lobbyState, teardown_game},
+        {"print_gameState_4p", setup_gameState, run_print_gameState, teardown_game},
+        {"print_playState_4p_r10", setup_playState, run_print_playState, teardown_game},
+        {"print_playDelta_4p_r10", setup_playDelta, run_print_playDelta, teardown_game},
+        {"hist_record", setup_hist, run_hist_record, NULL},
+        {"hist_merge_p99", setup_hist, run_hist_merge_p99, NULL},
+        {"analytics_card", NULL, run_analytics_card, NULL},
+};
+
+int main(int argc, char *argv[]) {
+    long min_time_ms = DEFAULT_MIN_TIME_MS;
+    const char *filter = NULL;
+    const char *output = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:f:o:")) != -1) {
+        switch (opt) {
+            case 't': min_time_ms = atol(optarg); break;
+            case 'f': filter = optarg; break;
+            case 'o': output = optarg; break;
+            default:
+                fprintf(stderr, "Usage : %s [-t min_time_ms] [-f filter] [-o output.jsonl]\n", argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    // The server functions print on stdout : keep it for the results only.
+    FILE *out = output ? fopen(output, "w") : fdopen(dup(STDOUT_FILENO), "w");
+    if (out == NULL) {
+        perror("ERROR opening output");
+        exit(EXIT_FAILURE);
+    }
+    if (freopen("/dev/null", "w", stdout) == NULL) {
+        perror("ERROR redirecting stdout");
+        exit(EXIT_FAILURE);
+    }
+
+    drain_epoll = epoll_create1(0);
+    pthread_t drainer;
+    pthread_create(&drainer, NULL, drain_peers, NULL);
+
+    for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); ++i) {
+        if (filter && strstr(benches[i].name, filter) == NULL) continue;
+        bench_run(&benches[i], min_time_ms, out);
+    }
+
+    draining = false;
+    pthread_join(drainer, NULL);
+    close(drain_epoll);
+    fclose(out);
+    return 0;
+}
@@ -0,0 +1,464 @@
+//
+// Created by erwan on 19/10/2026.
+//
+// End-to-end latency benchmark : starts TheMindServeur on loopback and drives scripted tables,
+// all seated by the matchmaker of this one server.
+// A play is measured from the moment the card is sent until every member of the table
+// received both the "name -> card" broadcast and its updated board.
+//
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <limits.h>
+#include <getopt.h>
+#include <signal.h>
+#include <libgen.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define MAX_TABLES 32
+#define MAX_TABLE_PLAYERS 4
+#define DEFAULT_SERVER "./bin/server/TheMindServeur"
+#define DEFAULT_PORT 6200
+#define LINE_SIZE 4096
+
+#define T_JOINING 0 // Waiting for every player to be seated
+#define T_DEALING 1 // "start" sent, waiting for the cards and the countdown
+#define T_PLAYING 2 // A card is in flight
+#define T_ROUND_END 3 // Waiting for the round result
+#define T_STOPPING 4 // "stop" sent, waiting for the end of the game
+
+typedef struct {
+    int fd;
+    int table;
+    int index; // Index in the table
+    char name[16];
+    char line[LINE_SIZE]; // Current line, ANSI codes removed
+    size_t line_len;
+    int ansi; // 0 text, 1 after '\e', 2 inside '\e[...'
+    int stage; // For the card in flight : 0 waiting the play, 1 waiting the board, 2 done
+} Client;
+
+typedef struct {
+    pid_t pid;
+    char workdir[PATH_MAX];
+    int port;
+} Server;
+
+typedef struct {
+    int id; // Table given by the server
+    int state;
+    int joined;
+    int cards_dealt;
+    int gos;
+    int owner[100]; // Index of the player holding the card, -1 if none
+    int card; // Card in flight
+    int delivered; // Members that received the card in flight
+    uint64_t sent_ns;
+    int round_in_game;
+    bool round_result; // The result of the round was received
+    Client clients[MAX_TABLE_PLAYERS];
+} Table;
+
+static int nb_players = 2;
+static int rounds_per_game = 1;
+static uint64_t *samples = NULL;
+static size_t sample_count = 0, sample_cap = 0;
+static unsigned long games_done = 0;
+static bool measuring = false;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void add_sample(uint64_t ns) {
+    if (!measuring) return;
+    if (sample_count == sample_cap) {
+        sample_cap = sample_cap ? sample_cap * 2 : 4096;
+        samples = realloc(samples, sample_cap * sizeof(uint64_t));
+        if (samples == NULL) {
+            perror("ERROR allocation samples");
+            exit(EXIT_FAILURE);
+        }
+    }
+    samples[sample_count++] = ns;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static double percentile_us(double q) {
+    if (sample_count == 0) return 0;
+    size_t idx = (size_t)(q * (sample_count - 1) + 0.5);
+    return samples[idx] / 1000.0;
+}
+
+static void send_cmd(Client *c, const char *cmd) {
+    if (send(c->fd, cmd, strlen(cmd), 0) <= 0) {
+        perror("ERROR sending command");
+    }
+}
+
+/*
+ * Server management
+ */
+static int rm_entry(const char *path, const struct stat *sb, int flag, struct FTW *ftw) {
+    return remove(path);
+}
+
+/**
+ * @brief Start a server in its own working directory, with the scripts and ressources of the build.
+ */
+static void start_server(const char *server_path, Server *srv) {
+    char server_abs[PATH_MAX], server_dir[PATH_MAX], link_src[PATH_MAX + 16], link_dst[PATH_MAX + 16];
+    if (realpath(server_path, server_abs) == NULL) {
+        perror("ERROR server path");
+        exit(EXIT_FAILURE);
+    }
+    snprintf(server_dir, sizeof(server_dir), "%s", server_abs);
+    dirname(server_dir);
+
+    snprintf(srv->workdir, sizeof(srv->workdir), "/tmp/themind-e2e-XXXXXX");
+    if (mkdtemp(srv->workdir) == NULL) {
+        perror("ERROR mkdtemp");
+        exit(EXIT_FAILURE);
+    }
+    const char *links[] = {"scripts", "ressources"};
+    for (int i = 0; i < 2; ++i) {
+        snprintf(link_src, sizeof(link_src), "%s/%s", server_dir, links[i]);
+        snprintf(link_dst, sizeof(link_dst), "%s/%s", srv->workdir, links[i]);
+        symlink(link_src, link_dst);
+    }
+    snprintf(link_dst, sizeof(link_dst), "%s/datas", srv->workdir);
+    mkdir(link_dst, 0755);
+    snprintf(link_dst, sizeof(link_dst), "%s/pdf", srv->workdir);
+    mkdir(link_dst, 0755);
+    snprintf(link_dst, sizeof(link_dst), "%s/datas/rank.dat", srv->workdir);
+    close(open(link_dst, O_CREAT | O_WRONLY, 0644));
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork");
+        exit(EXIT_FAILURE);
+    } else if (pid == 0) {
+        char port_str[8];
+        snprintf(port_str, sizeof(port_str), "%d", srv->port);
+        if (chdir(srv->workdir) == -1) _exit(EXIT_FAILURE);
+        int devnull = open("/dev/null", O_WRONLY);
+        dup2(devnull, STDOUT_FILENO);
+        dup2(devnull, STDERR_FILENO);
+        execl(server_abs, server_abs, port_str, "64", NULL);
+        _exit(EXIT_FAILURE);
+    }
+    srv->pid = pid;
+}
+
+static void stop_server(Server *srv) {
+    kill(srv->pid, SIGTERM);
+    for (int i = 0; i < 100; ++i) {
+        if (waitpid(srv->pid, NULL, WNOHANG) == srv->pid) {
+            nftw(srv->workdir, rm_entry, 16, FTW_DEPTH | FTW_PHYS);
+            return;
+        }
+        usleep(10000);
+    }
+    kill(srv->pid, SIGKILL);
+    waitpid(srv->pid, NULL, 0);
+    nftw(srv->workdir, rm_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+static int connect_retry(int port) {
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(port)};
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    for (int i = 0; i < 200; ++i) {
+        int fd = socket(PF_INET, SOCK_STREAM, 0);
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            return fd;
+        }
+        close(fd);
+        usleep(10000);
+    }
+    fprintf(stderr, "ERROR : server on port %d unreachable\n", port);
+    exit(EXIT_FAILURE);
+}
+
+/*
+ * Table script
+ */
+static void start_next(Table *t) {
+    t->state = T_DEALING;
+    t->round_result = false;
+    t->cards_dealt = 0;
+    t->gos = 0;
+    for (int i = 0; i < 100; ++i) t->owner[i] = -1;
+    send_cmd(&t->clients[0], "start");
+}
+
+/**
+ * @brief Start the next round, or stop the game, once the last play is delivered and the result received.
+ */
+static void end_round(Table *t) {
+    if (t->state != T_ROUND_END || !t->round_result) return;
+    t->round_in_game++;
+    if (t->round_in_game < rounds_per_game) {
+        start_next(t);
+    } else {
+        t->state = T_STOPPING;
+        send_cmd(&t->clients[0], "stop");
+    }
+}
+
+/**
+ * @brief Send the lowest card of the table from its owner.
+ */
+static void play_next(Table *t) {
+    int card = 1;
+    while (card < 100 && t->owner[card] == -1) card++;
+    if (card == 100) {
+        t->state = T_ROUND_END;
+        end_round(t);
+        return;
+    }
+    char cmd[8];
+    snprintf(cmd, sizeof(cmd), "%d", card);
+    Client *owner = &t->clients[t->owner[card]];
+    t->owner[card] = -1;
+    t->card = card;
+    t->delivered = 0;
+    for (int i = 0; i < nb_players; ++i) t->clients[i].stage = 0;
+    t->state = T_PLAYING;
+    t->sent_ns = now_ns();
+    send_cmd(owner, cmd);
+}
+
+static bool starts_with(const char *s, const char *prefix) {
+    return strncmp(s, prefix, strlen(prefix)) == 0;
+}
+
+/**
+ * @brief Advance the script of a table with one line received by one of its clients.
+ */
+static void on_line(Table *t, Client *c, const char *line) {
+    int card;
+    char name[64];
+    if (line[0] == '\0') return;
+
+    if (sscanf(line, "Carte : %d", &card) == 1) {
+        if (card > 0 && card < 100) t->owner[card] = c->index;
+        t->cards_dealt++;
+    } else if (strcmp(line, "La partie vas commencer dans : 3 2 1 Go !") == 0) {
+        if (++t->gos == nb_players && t->state == T_DEALING) play_next(t);
+    } else if (t->state == T_PLAYING && c->stage == 0 && sscanf(line, "%63s -> %d", name, &card) == 2) {
+        if (card == t->card) c->stage = 1;
+    } else if (t->state == T_PLAYING && c->stage == 1 && starts_with(line, "Plateau : ")) {
+        c->stage = 2;
+        if (++t->delivered == nb_players) {
+            add_sample(now_ns() - t->sent_ns);
+            play_next(t);
+        }
+    } else if (c->index == 0 && starts_with(line, "Bravo vous avez gagné la manche")) {
+        t->round_result = true;
+        end_round(t);
+    } else if (c->index == 0 && strstr(line, " est perdu !")) {
+        t->round_result = true; // Should not happen, the cards are played in order
+        t->state = T_ROUND_END;
+        end_round(t);
+    } else if (c->index == 0 && t->state == T_STOPPING && strcmp(line, "Prêt pour une nouvelle partie ?") == 0) {
+        if (measuring) games_done++;
+        t->round_in_game = 0;
+        start_next(t);
+    } else if (t->state == T_JOINING && sscanf(line, "Vous êtes à la table %d.", &card) == 1) {
+        if (t->joined == 0) t->id = card;
+        if (card != t->id) {
+            fprintf(stderr, "ERROR : players of a script seated at tables %d and %d\n", t->id, card);
+            exit(EXIT_FAILURE);
+        }
+        if (++t->joined == nb_players) start_next(t);
+    }
+}
+
+/**
+ * @brief Read a client socket, drop the ANSI codes and frame the lines.
+ * @return -1 if the connection is closed.
+ */
+static int on_readable(Table *t, Client *c) {
+    char buffer[BUFSIZ];
+    ssize_t len = recv(c->fd, buffer, sizeof(buffer), 0);
+    if (len <= 0) return -1;
+    for (ssize_t i = 0; i < len; ++i) {
+        char ch = buffer[i];
+        if (c->ansi == 1) {
+            c->ansi = ch == '[' ? 2 : 0;
+            if (c->ansi == 2) continue;
+        } else if (c->ansi == 2) {
+            if ((ch < '0' || ch > '9') && ch != ';') c->ansi = 0;
+            continue;
+        }
+        if (ch == '\e') {
+            c->ansi = 1;
+        } else if (ch == '\n') {
+            c->line[c->line_len] = '\0';
+            on_line(t, c, c->line);
+            c->line_len = 0;
+        } else if (c->line_len < LINE_SIZE - 1) {
+            c->line[c->line_len++] = ch;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Read the connections until every player of the table is seated.
+ */
+static void wait_seated(int epoll_fd, Table *tables, Table *t) {
+    struct epoll_event events[64];
+    uint64_t deadline = now_ns() + 10000000000ULL;
+    while (t->joined < nb_players) {
+        if (now_ns() > deadline) {
+            fprintf(stderr, "ERROR : players of a script not seated\n");
+            exit(EXIT_FAILURE);
+        }
+        int n = epoll_wait(epoll_fd, events, 64, 100);
+        for (int i = 0; i < n; ++i) {
+            Client *c = events[i].data.ptr;
+            if (on_readable(&tables[c->table], c) == -1) {
+                fprintf(stderr, "ERROR : connection closed while joining\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Run nb_tables tables on one server for warmup + duration seconds and append the result to out.
+ *
+ * The players of a script ask for a table of nb_players seats and connect one script after the other,
+ * so that the matchmaker seats each script at its own table.
+ */
+static void run_step(const char *server_path, int port, int nb_tables, int warmup_s, int duration_s, FILE *out) {
+    Table *tables = calloc(nb_tables, sizeof(Table));
+    int epoll_fd = epoll_create1(0);
+    if (tables == NULL || epoll_fd == -1) {
+        perror("ERROR step setup");
+        exit(EXIT_FAILURE);
+    }
+
+    Server srv = {.port = port};
+    start_server(server_path, &srv);
+    for (int i = 0; i < nb_tables; ++i) {
+        Table *t = &tables[i];
+        t->state = T_JOINING;
+        for (int j = 0; j < nb_players; ++j) {
+            Client *c = &t->clients[j];
+            c->fd = connect_retry(srv.port);
+            c->table = i;
+            c->index = j;
+            snprintf(c->name, sizeof(c->name), "E2E%d_%d", i, j);
+            struct epoll_event ev = {.events = EPOLLIN, .data.ptr = c};
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, c->fd, &ev);
+            char handshake[32];
+            snprintf(handshake, sizeof(handshake), "%s %d", c->name, nb_players);
+            send_cmd(c, handshake);
+        }
+        wait_seated(epoll_fd, tables, t);
+    }
+
+    sample_count = 0;
+    games_done = 0;
+    measuring = false;
+    uint64_t begin = now_ns();
+    uint64_t measure_begin = begin + (uint64_t)warmup_s * 1000000000ULL;
+    uint64_t end = measure_begin + (uint64_t)duration_s * 1000000000ULL;
+    struct epoll_event events[64];
+    uint64_t now;
+    while ((now = now_ns()) < end) {
+        if (!measuring && now >= measure_begin) measuring = true;
+        int n = epoll_wait(epoll_fd, events, 64, 100);
+        for (int i = 0; i < n; ++i) {
+            Client *c = events[i].data.ptr;
+            if (on_readable(&tables[c->table], c) == -1) {
+                fprintf(stderr, "ERROR : table %d closed the connection\n", c->table);
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+            }
+        }
+    }
+
+    qsort(samples, sample_count, sizeof(uint64_t), cmp_u64);
+    fprintf(out, "{\"tables\":%d,\"players\":%d,\"rounds_per_game\":%d,\"plays\":%zu,"
+                 "\"p50_us\":%.1f,\"p99_us\":%.1f,\"p999_us\":%.1f,\"max_us\":%.1f,\"games_per_s\":%.3f}\n",
+            nb_tables, nb_players, rounds_per_game, sample_count,
+            percentile_us(0.50), percentile_us(0.99), percentile_us(0.999), percentile_us(1.0),
+            (double)games_done / duration_s);
+    fflush(out);
+
+    for (int i = 0; i < nb_tables; ++i) {
+        for (int j = 0; j < nb_players; ++j) close(tables[i].clients[j].fd);
+    }
+    stop_server(&srv);
+    close(epoll_fd);
+    free(tables);
+}
+
+int main(int argc, char *argv[]) {
+    const char *server_path = DEFAULT_SERVER;
+    const char *output = NULL;
+    char tables_list[256] = "1,2,4";
+    int port = DEFAULT_PORT;
+    int duration_s = 20, warmup_s = 2;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:p:T:n:r:d:w:o:")) != -1) {
+        switch (opt) {
+            case 's': server_path = optarg; break;
+            case 'p': port = atoi(optarg); break;
+            case 'T': snprintf(tables_list, sizeof(tables_list), "%s", optarg); break;
+            case 'n': nb_players = atoi(optarg); break;
+            case 'r': rounds_per_game = atoi(optarg); break;
+            case 'd': duration_s = atoi(optarg); break;
+            case 'w': warmup_s = atoi(optarg); break;
+            case 'o': output = optarg; break;
+            default: nb_players = -1;
+        }
+    }
+    if (nb_players < 1 || nb_players > MAX_TABLE_PLAYERS || rounds_per_game < 1 || duration_s < 1) {
+        fprintf(stderr, "Usage : %s [-s server] [-p port] [-T 1,2,4] [-n players] [-r rounds_per_game] "
+                        "[-d seconds] [-w warmup_seconds] [-o results.jsonl]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    FILE *out = output ? fopen(output, "w") : stdout;
+    if (out == NULL) {
+        perror("ERROR opening output");
+        exit(EXIT_FAILURE);
+    }
+
+    for (char *tok = strtok(tables_list, ","); tok; tok = strtok(NULL, ",")) {
+        int nb_tables = atoi(tok);
+        if (nb_tables < 1 || nb_tables > MAX_TABLES) continue;
+        run_step(server_path, port, nb_tables, warmup_s, duration_s, out);
+    }
+
+    if (out != stdout) fclose(out);
+    free(samples);
+    return 0;
+}
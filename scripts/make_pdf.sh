@@ -29,7 +29,7 @@ fi
 # Fonction pour extraire une valeur depuis le fichier stats
 get_value() {
     local key="$1"
-    grep -m1 "^$key" "$STATS_FILE" | awk '{print $2}' # -m1 pour garder que la 1ère occurence commencant par key.
+    grep -m1 "^$key " "$STATS_FILE" | awk '{print $2}' # -m1 pour garder que la 1ère occurence, l'espace évite ROUNDS -> ROUNDSLIST.
 }
 
 # Fonction pour remplacer une valeur dans le fichier LaTeX
@@ -46,6 +46,7 @@ DATA_ROUNDS=$(get_value "ROUNDS")
 DATA_WINROUNDS=$(get_value "WINROUNDS")
 DATA_MAXROUND=$(get_value "MAXROUNDS")
 DATA_TIME=$(get_value "REACTIONTIME")
+DATA_PERCENTILES=$(grep -m1 "^REACTIONPERCENTILES " "$STATS_FILE" | awk '{print $2 " \\/ " $3 " \\/ " $4}')
 
 # Mettre à jour le fichier LaTeX
 replace_data "%DATA_PLAYERS" "$DATA_PLAYERS" "$TEXFILE"
@@ -53,6 +54,7 @@ replace_data "%DATA_ROUNDS" "$DATA_ROUNDS" "$TEXFILE"
 replace_data "%DATA_WINROUNDS" "$DATA_WINROUNDS" "$TEXFILE"
 replace_data "%DATA_MAXROUND" "$DATA_MAXROUND" "$TEXFILE"
 replace_data "%DATA_TIME" "$DATA_TIME" "$TEXFILE"
+replace_data "%DATA_PERCENTILES" "$DATA_PERCENTILES" "$TEXFILE"
 
 # Compiler le fichier LaTeX
 pdflatex -jobname="$OUTPUTFILE" "$TEXFILE" > /dev/null 2>&1
@@ -3,8 +3,21 @@
 //
 
 
+#include <errno.h>
 #include "Game.h"
 
+static int next_game_id = 0;
+
+/**
+ * @brief Sends a public message to the players and to the spectators of the table.
+ * @param msg Message, encoded once for everybody.
+ * @param len Length of the message.
+ */
+static void publish(Game *g, Player *exclude, int params, const char *msg, int len){
+    broadcast_raw(g->playerList,exclude,params,msg,len);
+    spectators_publish(g->spectators,msg,len);
+}
+
 /**
  * @brief Creates and initializes a new game.
  *
@@ -18,16 +31,28 @@
  *
  */
 Game *create_game(PlayerList *pl) {
-    Game *game = malloc(sizeof (Game));
+    Game *game = mem_malloc(MEM_GAME,sizeof (Game));
     if(game == NULL) return NULL;
+    game->id = __atomic_fetch_add(&next_game_id,1,__ATOMIC_RELAXED);
+    game->size = 0;
+    atomic_init(&game->lobby_players,0);
+    game->reserved = 0;
     game->playerList = pl;
     game->round = DEFAULT_ROUND;
     game->cards_queue = create_queue();
-    game->board = NULL;
+    memset(game->owner,0,sizeof(game->owner));
+    memset(game->board,0,sizeof(game->board));
     game->played_cards_count =0;
     game->state = LOBBY_STATE;
     game->gameData = NULL;
-    pthread_rwlock_init(&game->mutex,NULL);
+    game->spectators = create_spectators();
+    game->handler = NULL;
+    game->state_dirty = false;
+    game->last_render_ms = 0;
+    game->countdown_step = -1;
+    game->nb_held = 0;
+    atomic_init(&game->stopped,false);
+    mailbox_init(&game->mailbox);
     return game;
 }
 /**
@@ -37,13 +62,337 @@ Game *create_game(PlayerList *pl) {
  */
 void free_game(Game *g) {
     if (g) {
-        if (g->board)
-            free(g->board);
-        pthread_rwlock_destroy(&g->mutex);
-        free(g->gameData);
+        free_gm(g->gameData);
+        free_spectators(g->spectators);
+        mailbox_destroy(&g->mailbox);
         destroy_queue(g->cards_queue);
-        free(g);
+        mem_free(MEM_GAME,g);
+    }
+}
+static long long now_ms(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+/**
+ * @brief Ask for a render of the lobby or game state screen.
+ *
+ * The screen is sent by the executor at most once per STATE_RENDER_MS, so that a burst of
+ * joins or ready changes costs one render for the whole table.
+ */
+void request_state_render(Game *g){
+    g->state_dirty = true;
+}
+/**
+ * @brief Render the state screen if asked and the last render is old enough.
+ * @return Milliseconds before the pending render, or -1 if none is pending.
+ */
+static int render_state(Game *g){
+    if(!g->state_dirty) return -1;
+    long long now = now_ms();
+    long long wait = g->last_render_ms + STATE_RENDER_MS - now;
+    if(wait > 0) return (int)wait;
+
+    g->state_dirty = false;
+    g->last_render_ms = now;
+    if(g->state == LOBBY_STATE){
+        print_lobbyState(g);
+    } else if(g->state == GAME_STATE){
+        print_gameState(g);
+    } // The play screen is sent by every play
+    return -1;
+}
+/**
+ * @brief Send the countdown steps that are due, the cards can be played from "Go".
+ * @return Milliseconds before the next step, or -1 if no countdown is running.
+ */
+static int countdown_tick(Game *g){
+    while(g->countdown_step >= 0){
+        long long wait = g->countdown_ms - now_ms();
+        if(wait > 0) return (int)wait;
+        if(g->countdown_step > 0){
+            broadcast_game(g,NULL,B_CONSOLE,MSG_COUNTDOWN_STEP,MSG_ARGS(ARG_D(g->countdown_step)));
+            g->countdown_step--;
+            g->countdown_ms += g->countdown_delay_ms;
+        } else {
+            broadcast_game(g,NULL,B_CONSOLE,MSG_COUNTDOWN_GO,NULL);
+            g->countdown_step = -1;
+            g->start_ns = trace_now(); // Reaction times start at "Go"
+        }
+    }
+    return -1;
+}
+/**
+ * @brief Earliest of two delays in milliseconds, -1 meaning none.
+ */
+static int earliest(int a, int b){
+    if(a < 0) return b;
+    if(b < 0) return a;
+    return a < b ? a : b;
+}
+/**
+ * @brief Keep the seat of a player whose connection was lost, the game goes on without teardown.
+ *
+ * The player can take it back with its session token during SESSION_GRACE seconds, then it leaves the table.
+ */
+void hold_player(Game *g, Player *p){
+    close_player_socket(p);
+    p->held_since = time(NULL);
+    g->nb_held++;
+    broadcast_game(g,p,B_CONSOLE,MSG_HELD,MSG_ARGS(ARG_S(p->name),ARG_D(SESSION_GRACE)));
+}
+/**
+ * @brief Free the held seats whose grace delay is over, as if the players had left.
+ * @return Milliseconds before the next expiry, or -1 if no seat is held.
+ */
+static int expire_seats(Game *g){
+    while(g->nb_held > 0){
+        time_t now = time(NULL);
+        Player *expired = NULL;
+        time_t next = 0;
+        int slot;
+        PlayerSnapshot *snap = read_players(g->playerList,&slot);
+        for (int i = 0; i < snap->count; ++i) {
+            Player *p = snap->players[i];
+            if(p->held_since == 0) continue;
+            if(now - p->held_since >= SESSION_GRACE){
+                expired = p;
+                break;
+            }
+            if(next == 0 || p->held_since < next) next = p->held_since;
+        }
+        release_players(g->playerList,slot);
+
+        if(expired == NULL) return next == 0 ? -1 : (int)(next + SESSION_GRACE - now) * 1000;
+        expired->held_since = 0;
+        g->nb_held--;
+        RoomMsg leave = {.type = ROOM_LEAVE, .p = expired, .gen = atomic_load(&expired->gen), .fd = -1, .reply = NULL};
+        g->handler(g,&leave);
+    }
+    return -1;
+}
+/**
+ * @brief Give a held seat to a new connection, called by the executor.
+ *
+ * A seat still bound to a connection (lost but not detected yet) is taken over, the old
+ * connection is shut down and closed when its ROOM_DROP comes.
+ *
+ * @param fd Socket of the new connection.
+ * @param token Session token sent by the client.
+ * @return The player, or NULL if no seat of the table has this token.
+ */
+Player *resume_player(Game *g, int fd, const char *token){
+    Player *p = NULL;
+    int slot;
+    PlayerSnapshot *snap = read_players(g->playerList,&slot);
+    for (int i = 0; i < snap->count; ++i) {
+        if(strcmp(snap->players[i]->token,token) == 0){
+            p = snap->players[i];
+            break;
+        }
     }
+    release_players(g->playerList,slot);
+    if(p == NULL) return NULL;
+
+    if(p->socket_fd >= 0) shutdown(p->socket_fd,SHUT_RDWR);
+    if(p->held_since != 0) g->nb_held--;
+    p->socket_fd = fd;
+    p->held_since = 0;
+
+    send_msg(p,MSG_RESUMED,MSG_ARGS(ARG_D(g->id)));
+    broadcast_game(g,p,B_CONSOLE,MSG_BACK,MSG_ARGS(ARG_S(p->name)));
+    if(g->state == PLAY_STATE && p->in_round){
+        Queue hand = p->hand;
+        while(!isEmpty(&hand)){
+            send_msg(p,MSG_HAND_CARD,MSG_ARGS(ARG_D(dequeue(&hand))));
+        }
+        if(g->countdown_step >= 0){
+            // The steps already sent, the next ones and "Go" come with the broadcasts.
+            send_msg(p,MSG_COUNTDOWN,NULL);
+            for (int step = 3; step > g->countdown_step; --step) {
+                send_msg(p,MSG_COUNTDOWN_STEP,MSG_ARGS(ARG_D(step)));
+            }
+        } else {
+            int last = g->played_cards_count > 0 ? g->board[g->played_cards_count - 1] : 0;
+            send_msg(p,MSG_RESUME_PLAY,MSG_ARGS(ARG_D(last)));
+        }
+    } else {
+        request_state_render(g);
+    }
+    return p;
+}
+/**
+ * @brief Post a message with a reply to the executor and wait for its answer.
+ *
+ * The executor answers the messages still pending when it stops. A message posted after that is never
+ * handled : the wait ends once the executor is seen stopped.
+ *
+ * @return The player of the answer, NULL if the executor stopped.
+ */
+static Player *wait_reply(Game *g, RoomMsg *msg){
+    RoomReply reply = {.player = NULL};
+    sem_init(&reply.done,0,0);
+    msg->reply = &reply;
+    mailbox_push(&g->mailbox,msg);
+    while(1){
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME,&deadline);
+        deadline.tv_sec += REPLY_POLL_MS / 1000;
+        deadline.tv_nsec += (REPLY_POLL_MS % 1000) * 1000000L;
+        if(deadline.tv_nsec >= 1000000000L){
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        if(sem_timedwait(&reply.done,&deadline) == 0) break;
+        if(errno == ETIMEDOUT && atomic_load(&g->stopped)){
+            if(sem_trywait(&reply.done) == 0) break; // Answered just before the end
+            reply.player = NULL;
+            break;
+        }
+    }
+    sem_destroy(&reply.done);
+    return reply.player;
+}
+/**
+ * @brief Ask the executor for the seat of a session token, called by a client thread.
+ *
+ * Blocks until the executor answers.
+ *
+ * @param fd Socket of the client, owned by the player on success.
+ * @return The player, or NULL if the token is unknown or expired.
+ */
+Player *resume_session(Game *g, int fd, const char *token){
+    RoomMsg *msg = room_msg(ROOM_RESUME,NULL,token);
+    if(msg == NULL) return NULL;
+    msg->fd = fd;
+    return wait_reply(g,msg);
+}
+/**
+ * @brief Ask the executor to take a seat given by the matchmaker, called by a client thread.
+ *
+ * Only the executor creates players : the seat is refused if the table left the lobby or is full.
+ *
+ * @param fd Socket of the client, owned by the player on success.
+ * @return The player, or NULL if the seat is refused.
+ */
+Player *request_seat(Game *g, int fd, const char *name, int admin){
+    RoomMsg *msg = room_msg(ROOM_JOIN,NULL,name);
+    if(msg == NULL) return NULL;
+    msg->fd = fd;
+    msg->admin = admin;
+    return wait_reply(g,msg);
+}
+/**
+ * @brief Executor of a table : the only thread that reads and writes the game state.
+ *
+ * Client threads post their commands in the mailbox, they are handled one at a time in arrival order,
+ * so the game functions don't need any lock.
+ */
+static void *run_executor(void *arg){
+    Game *g = arg;
+    trace_set_room(g->id);
+    bool running = true;
+    int timeout = -1;
+    while(running){
+        // One tick : the messages already posted are handled, then the output is flushed once.
+        RoomMsg *msg = mailbox_wait(&g->mailbox,timeout);
+        tick_begin(&g->tick);
+        for (int n = 0; msg != NULL; ++n) {
+            if(msg->type == ROOM_STOP){
+                running = false;
+            } else if(msg->p == NULL || atomic_load(&msg->p->gen) == msg->gen){
+                g->handler(g,msg);
+            } // Otherwise the slot of the sender was released, maybe reused by another player : stale message
+            mem_free(MEM_NETWORK,msg);
+            msg = running && n + 1 < ROOM_TICK_MAX ? mailbox_wait(&g->mailbox,0) : NULL;
+        }
+        if(running){
+            int step = countdown_tick(g);
+            int expiry = expire_seats(g);
+            int render = render_state(g);
+            timeout = earliest(earliest(step,expiry),render);
+        } else {
+            timeout = -1;
+        }
+        tick_end();
+    }
+
+    // Messages posted before the stop are not handled, the client threads waiting for a reply are answered.
+    RoomMsg *msg;
+    while((msg = mailbox_wait(&g->mailbox,0)) != NULL){
+        if(msg->reply != NULL){
+            msg->reply->player = NULL;
+            sem_post(&msg->reply->done);
+        }
+        mem_free(MEM_NETWORK,msg);
+    }
+    atomic_store(&g->stopped,true);
+    return NULL;
+}
+/**
+ * @brief Start the executor thread of a table.
+ * @param handler Function called by the executor for every message.
+ * @return 0 on success, -1 if the thread can't be created.
+ */
+int start_executor(Game *g, room_handler handler){
+    g->handler = handler;
+    if(pthread_create(&g->executor,NULL,run_executor,g) != 0){
+        perror("ERROR creating executor thread");
+        return -1;
+    }
+    return 0;
+}
+/**
+ * @brief Stop the executor after the messages already posted, and wait for it.
+ */
+void stop_executor(Game *g){
+    if(g->handler == NULL) return;
+    post_room(g,ROOM_STOP,NULL,NULL);
+    pthread_join(g->executor,NULL);
+    g->handler = NULL;
+}
+/**
+ * @brief Post the end of a connection to the executor of the table, never blocks.
+ * @param type ROOM_LEAVE when the player quits, ROOM_DROP when the connection is lost.
+ * @param fd Socket of the connection, the seat may already be bound to a newer one.
+ */
+void post_disconnect(Game *g, int type, Player *p, int fd){
+    RoomMsg *msg = room_msg(type,p,NULL);
+    if(msg == NULL) return;
+    msg->fd = fd;
+    mailbox_push(&g->mailbox,msg);
+}
+/**
+ * @brief Post a message to the executor of the table, never blocks.
+ * @param type ROOM_COMMAND, ROOM_STOP or ROOM_SHUTDOWN.
+ * @param p Player who sends the message.
+ * @param cmd Command text, NULL if none.
+ */
+void post_room(Game *g, int type, Player *p, const char *cmd){
+    RoomMsg *msg = room_msg(type,p,cmd);
+    if(msg == NULL) return;
+    mailbox_push(&g->mailbox,msg);
+}
+/**
+ * @brief Broadcasts a public event of the table (plays, rounds results...), also seen by the spectators.
+ *
+ * Hands and personal messages must go through send_msg, never through this function.
+ *
+ * @param g A pointer to the `Game` object.
+ * @param exclude Player who doesn't receive the message, or NULL. Spectators always receive it.
+ * @param params B_CONSOLE to display the message in the server console.
+ * @param id Message of the catalog.
+ * @param args Arguments of the message, NULL if none.
+ */
+void broadcast_game(Game *g, Player *exclude, int params, int id, const MsgArg *args){
+    char buffers[MSG_STYLES][MSG_SIZE];
+    const char *msgs[MSG_STYLES];
+    int lengths[MSG_STYLES];
+    for (int style = 0; style < MSG_STYLES; ++style) {
+        msgs[style] = msg_render(buffers[style],MSG_SIZE,id,style,args,&lengths[style]);
+    }
+    broadcast_styled(g->playerList,exclude,params,msgs,lengths);
+    spectators_publish(g->spectators,msgs[MSG_COLOR],lengths[MSG_COLOR]);
 }
 /**
  * @brief Starts a new game if the conditions are met.
@@ -55,19 +404,37 @@ void free_game(Game *g) {
  *         due to invalid conditions (e.g., not all players are ready or the game is already in progress).
  */
 int start_game(Game *g,Player *p) {
-    pthread_rwlock_wrlock(&g->mutex);
     if(get_ready_count(g->playerList) != g->playerList->count || g->state == PLAY_STATE || g->state == GAME_STATE){
-        pthread_rwlock_unlock(&g->mutex);
         return -1;
     }
     g->gameData = create_gm(); // Create GameData stats
     g->gameData->player_count = g->playerList->count; // Set the player number
+    int slot;
+    PlayerSnapshot *snap = read_players(g->playerList,&slot);
+    for (int i = 0; i < snap->count; ++i) {
+        hist_reset(&snap->players[i]->reaction);
+    }
+    release_players(g->playerList,slot);
     g->state = GAME_STATE;
-    broadcast_message(g->playerList,NULL,B_CONSOLE,GRN"\n%s a lancé la partie ! (joueurs : %d)\n\n"CRESET,p->name,g->playerList->count);
-    pthread_rwlock_unlock(&g->mutex);
+    broadcast_game(g,NULL,B_CONSOLE,MSG_GAME_START,MSG_ARGS(ARG_S(p->name),ARG_D(g->playerList->count)));
     start_round(g,p);
     return 0;
 }
+/**
+ * @brief Add the round to the profile of each player dealt in it.
+ */
+static void update_profiles(Game *g, int win){
+    int slot;
+    PlayerSnapshot *snap = read_players(g->playerList,&slot);
+    for (int i = 0; i < snap->count; ++i) {
+        Player *p = snap->players[i];
+        if (!p->in_round) continue;
+        profile_add_round(p->name,g->round,win,p->lost_card,&p->round_reaction);
+        hist_reset(&p->round_reaction);
+        p->lost_card = false;
+    }
+    release_players(g->playerList,slot);
+}
 /**
  * @brief Starts a new round of the game if the conditions are met.
  *
@@ -80,30 +447,32 @@ int start_game(Game *g,Player *p) {
  *         due to invalid conditions (e.g., not all players are ready or the game is already in progress).
  */
 int start_round(Game *g,Player *p){
-    pthread_rwlock_wrlock(&g->mutex);
+    TRACE_BEGIN(span);
     if(get_ready_count(g->playerList) != g->playerList->count || g->state == PLAY_STATE){
-        pthread_rwlock_unlock(&g->mutex);
+        return -1;
+    }
+    if(g->playerList->count * g->round > MAX_CARDS){
         return -1;
     }
 
-    g->board = calloc((g->playerList->count * g->round),sizeof (int));
     g->state = PLAY_STATE;
+    analytics_table(g->id);
 
-    broadcast_message(g->playerList,NULL,B_CONSOLE,GRN"\n%s a lancé le round (niveau :%d)\n\n"CRESET,p->name,g->round);
+    broadcast_game(g,NULL,B_CONSOLE,MSG_ROUND_START,MSG_ARGS(ARG_S(p->name),ARG_D(g->round)));
 
-    init_player_card(g->playerList,g->round); // Malloc player's deck
+    init_player_card(g->playerList); // Empty hands
     distribute_card(g);
-    print_playState(g);
-    countdown(g,1); // Countdown broadcast.
-    g->startingTime = time(NULL); // Init current timer.
-    pthread_rwlock_unlock(&g->mutex);
+    print_playState(g,true); // Full snapshot for everybody
+    countdown(g,1); // Countdown broadcast by the executor.
+    g->start_ns = trace_now(); // Replaced at "Go", kept if the round ends before.
+    TRACE_END_ROOM(span,"start_round",g->id);
     return 0;
 }
 /**
  * @brief Ends the current round and handles the results based on the win status.
  *
  * Update Game state.
- * Free temporary ressources like players card and game board, reseting queue.
+ * Clear the ressources of the round (players cards, game board, queue), without any free : they live as long as the table.
  *
  * @param g A pointer to the `Game` object where the round will be ended.
  * @param win An integer indicating the outcome of the round:
@@ -111,27 +480,33 @@ int start_round(Game *g,Player *p){
  *            - 0 if the round was lost by the players.
  */
 void end_round(Game *g, int win){
+    TRACE_BEGIN(span);
+    g->countdown_step = -1; // A player may leave during the countdown
+    update_profiles(g,win);
+    analytics_round(g->id,g->round,win,trace_now() - g->start_ns);
     if(win){
-        broadcast_message(g->playerList,NULL,0,GRN"\nBravo vous avez gagné la manche %d\n\n"CRESET,g->round);
+        broadcast_game(g,NULL,0,MSG_ROUND_WON,MSG_ARGS(ARG_D(g->round)));
         add_round(g->gameData,g->round,1); // Add 1 winning round to GameData
 
         //Check if next manche is possible, if there's enough card for every player.
-        if((g->round + 1) * (g->playerList->count) <= 99){
+        if((g->round + 1) * (g->playerList->count) <= MAX_CARDS){
             g->round++;
         }
 
     } else {
-        broadcast_message(g->playerList,NULL,0,GRN"\nLa manche %d est perdu !\n\n"CRESET,g->round);
+        broadcast_game(g,NULL,0,MSG_ROUND_LOST,MSG_ARGS(ARG_D(g->round)));
         add_round(g->gameData,g->round,0); // Add 1 loosing round to GameData
         g->round = DEFAULT_ROUND;
     }
 
     free_players_card(g->playerList);
-    free(g->board); g->board = NULL;
+    memset(g->owner,0,sizeof(g->owner));
+    memset(g->board,0,g->played_cards_count * sizeof(int)); // Only the played slots are set
     g->played_cards_count = 0;
     reset_queue(g->cards_queue);
     g->state = GAME_STATE;
     print_gameState(g);
+    TRACE_END_ROOM(span,"end_round",g->id);
 }
 /**
  * @brief Ends the game and resets it to the lobby state.
@@ -147,26 +522,30 @@ void end_round(Game *g, int win){
  */
 void end_game(Game *g, Player* p, bool hard_disco){
     if(g->state == LOBBY_STATE) return;
+    TRACE_BEGIN(span);
     g->state = LOBBY_STATE;
     if(hard_disco){
-        broadcast_message(g->playerList,p,B_CONSOLE,GRN"\n%s a mis fin a la partie, retour au lobby\n\n"CRESET,p->name);
+        broadcast_game(g,p,B_CONSOLE,MSG_GAME_STOPPED,MSG_ARGS(ARG_S(p->name)));
     } else {
-        broadcast_message(g->playerList,NULL,B_CONSOLE,GRN"\n%s a mis fin a la partie, retour au lobby\n\n"CRESET,p->name);
+        broadcast_game(g,NULL,B_CONSOLE,MSG_GAME_STOPPED,MSG_ARGS(ARG_S(p->name)));
         p = NULL;
     }
 
     send_stats(g,p);
-    char** names= malloc(g->playerList->count * sizeof(char*));
-    for (int i = 0; i < g->playerList->count; i++) {
-        names[i] = strdup(g->playerList->players[i]->name);
+    int slot;
+    PlayerSnapshot *snap = read_players(g->playerList,&slot);
+    char** names= mem_malloc(MEM_GAME,snap->count * sizeof(char*));
+    for (int i = 0; i < snap->count; i++) {
+        names[i] = mem_strdup(MEM_GAME,snap->players[i]->name);
     }
 
-    write_game_rank(g->gameData,names);
+    write_game_rank(g->gameData,names,snap->count);
 
-    for (int i = 0; i < g->playerList->count; i++) {
-        free(names[i]);
+    for (int i = 0; i < snap->count; i++) {
+        mem_free(MEM_GAME,names[i]);
     }
-    free(names);
+    mem_free(MEM_GAME,names);
+    release_players(g->playerList,slot);
 
     print_classement(g,p); //Envoie le classement
 
@@ -174,7 +553,8 @@ void end_game(Game *g, Player* p, bool hard_disco){
     g->gameData = NULL;
     g->round = DEFAULT_ROUND;
 
-    broadcast_message(g->playerList,p,0,GRN"\nPrêt pour une nouvelle partie ?\n\n"CRESET);
+    broadcast_game(g,p,0,MSG_NEW_GAME,NULL);
+    TRACE_END_ROOM(span,"end_game",g->id);
 }
 /**
  * @brief Distributes cards to the players for the current round.
@@ -186,19 +566,18 @@ void end_game(Game *g, Player* p, bool hard_disco){
  *
  * @param g A pointer to the `Game` object in which the cards will be distributed.
  * @note The function modifies the players' decks by assigning the cards, and also modifies the game’s
- *       card queue by enqueuing each card as it is distributed. After the distribution, the card queue
- *       is sorted.
+ *       card queue by enqueuing each card as it is distributed. The card queue keeps its cards sorted.
  */
 void distribute_card(Game *g){
     PlayerList *pl = g->playerList;
 
-    int deck[99];
+    int deck[MAX_CARDS];
     /* Remplit le deck avec les cartes de 1 à 99*/
-    for (int i = 0; i < 99; ++i) {
+    for (int i = 0; i < MAX_CARDS; ++i) {
         deck[i] = i + 1;
     }
     /* Mélange le deck (Fisher-Yates) */
-    for (int i = 98 ; i > 0; i--) {
+    for (int i = MAX_CARDS - 1 ; i > 0; i--) {
         int j = rand() % (i+1);
 
         int temp = deck[i];
@@ -207,16 +586,20 @@ void distribute_card(Game *g){
     }
 
     // Distributed cards
+    int slot;
+    PlayerSnapshot *snap = read_players(pl,&slot);
     int card_index = 0;
     for (int i = 0; i <g->round; ++i) {
-        for (int j = 0; j < pl->count; ++j) {
-            pl->players[j]->cards[i] = deck[card_index]; // Add card to player deck
+        for (int j = 0; j < snap->count; ++j) {
+            if (!snap->players[j]->in_round) continue; // Seated after the start of the round
+            enqueue(&snap->players[j]->hand,deck[card_index]); // Add card to player deck
+            g->owner[deck[card_index]] = snap->players[j];
             enqueue(g->cards_queue,deck[card_index]); // Add card to game_cards
-            send_p(pl->players[j],BLK"Carte : %d\n"CRESET,deck[card_index]); // Send message to player.
+            send_msg(snap->players[j],MSG_HAND_CARD,MSG_ARGS(ARG_D(deck[card_index]))); // Send message to player.
             card_index++;
         }
     }
-    sort_queue(g->cards_queue); // Sort the cards_queue
+    release_players(pl,slot);
 }
 /**
  * @brief Handles the action of a player playing a card during the game.
@@ -238,59 +621,52 @@ void distribute_card(Game *g){
  * - `0` if the card is played successfully and no round ends.
  */
 int play_card(Game *g, Player *p, int card){
-    pthread_rwlock_wrlock(&g->mutex);
-
-    if(p->cards == NULL || card < 0 || card > 99) {
-        pthread_rwlock_unlock(&g->mutex);
-        return NO_CARD;
-    }
+    TRACE_BEGIN(span);
 
     //Check if player have this card
-    int have_card = 0;
-    for (int i = 0; i <= g->round; ++i) {
-        if(p->cards[i] == card){
-            p->cards[i] = 0; // Remove card from player
-            have_card = 1;
-            break;
-        }
-    }
-
-    if(!have_card || card == 0){
-        pthread_rwlock_unlock(&g->mutex);
+    if(card < 1 || card > 99 || g->owner[card] != p) {
+        TRACE_END_ROOM(span,"play_card",g->id);
         return NO_CARD;
     }
+    g->owner[card] = NULL; // Remove card from player
+    queue_remove(&p->hand,card);
 
-    broadcast_message(g->playerList,NULL,B_CONSOLE,GRN"\n%s -> %d\n\n"CRESET,p->name,card);
+    broadcast_game(g,NULL,B_CONSOLE,MSG_PLAY,MSG_ARGS(ARG_S(p->name),ARG_D(card)));
+
+    uint64_t reaction_ns = trace_now() - g->start_ns; // Since the start of the round
+    hist_record(&p->reaction,reaction_ns);
+    hist_record(&p->round_reaction,reaction_ns);
 
     if(card != peek(g->cards_queue)){
         //Branch when the card loose the round, refused
-        time_t delta_time = time(NULL) - g->startingTime; // Calc delta time with the starting time of the round.
-        add_loosing_card(g->gameData,card,delta_time);
+        add_loosing_card(g->gameData,card,reaction_ns);
+        p->lost_card = true;
 
-        print_playState(g);
+        print_playState(g,false);
+        print_playDelta(g,p,card,-1);
 
         end_round(g,0);
-        pthread_rwlock_unlock(&g->mutex); // Cares to unlock mutex AFTER calling loose round
+        TRACE_END_ROOM(span,"play_card",g->id);
         return WRONG_CARD;
     } else {
         //Branch when the card is accepted
 
-        time_t delta_time = time(NULL) - g->startingTime; // Calc delta time with the starting time of the round.
-        add_card(g->gameData,card,delta_time);
+        add_card(g->gameData,card,reaction_ns);
 
         g->board[g->played_cards_count] = dequeue(g->cards_queue);
         g->played_cards_count++;
 
-        print_playState(g);
+        print_playState(g,false);
+        print_playDelta(g,p,card,g->played_cards_count - 1);
 
         //If all cards played, win the round
         if(isEmpty(g->cards_queue)){
             end_round(g,1);
-            pthread_rwlock_unlock(&g->mutex);
+            TRACE_END_ROOM(span,"play_card",g->id);
             return ROUND_WIN;
         }
     }
-    pthread_rwlock_unlock(&g->mutex);
+    TRACE_END_ROOM(span,"play_card",g->id);
     return 0;
 }
 /**
@@ -305,20 +681,13 @@ int play_card(Game *g, Player *p, int card){
  * - The result of the `update_ready_player` function if the state is successfully updated.
  */
 int set_ready_player(Game *g, Player *p, int state) {
-    pthread_rwlock_rdlock(&g->mutex);
     if(g->state == PLAY_STATE) {
-        pthread_rwlock_unlock(&g->mutex);
         return -2;
     }
     int res = update_ready_player(g->playerList,p,state);
     if(res == 0){
-        if(g->state == LOBBY_STATE){
-            print_lobbyState(g);
-        } else if(g->state == GAME_STATE){
-            print_gameState(g);
-        }
+        request_state_render(g);
     }
-    pthread_rwlock_unlock(&g->mutex);
     return res;
 }
 /**
@@ -334,10 +703,17 @@ void send_stats(Game*g,Player *p){
     if(g->gameData == NULL){
         return;
     }
-    pthread_rwlock_wrlock(&g->mutex);
 
-    create_uf(g->gameData);
-    write_data_to_file(g->gameData);
+    if(write_data_to_file(g->gameData) == -1){
+        broadcast_msg(g->playerList,p,B_CONSOLE,MSG_STATS_FAILED,NULL);
+        return;
+    }
+    int slot;
+    PlayerSnapshot *snap = read_players(g->playerList,&slot);
+    for (int i = 0; i < snap->count; ++i) {
+        write_player_reaction(g->gameData,snap->players[i]->name,&snap->players[i]->reaction);
+    }
+    release_players(g->playerList,slot);
     make_dg(g->gameData->data_fp);
     make_pdf(g->gameData->data_fp);
 
@@ -347,126 +723,240 @@ void send_stats(Game*g,Player *p){
     } else {
         filename = g->gameData->data_fp;
     }
-    broadcast_message(g->playerList,p,B_CONSOLE,STAT_FILE_DL,filename,filename);
+    broadcast_msg(g->playerList,p,B_CONSOLE,MSG_STATS_FILE,MSG_ARGS(ARG_S(filename),ARG_S(filename)));
 
-    pthread_rwlock_unlock(&g->mutex);
 }
 /**
- * @brief Performs a countdown for the players before starting the card play phase.
+ * @brief Starts the countdown before the card play phase, its steps are sent by the executor.
  *
  * @param g A pointer to the `Game` object where the countdown will be performed.
- * @param sleep_delta The time (in seconds) to wait between each countdown message.
- * @note The function uses `sleep` to introduce a delay between the messages, so the countdown is visible to the players.
+ * @param sleep_delta The time (in seconds) between each countdown message.
+ * @note The executor keeps handling the messages of the table meanwhile, see countdown_tick.
  */
 void countdown(Game *g,int sleep_delta){
-    broadcast_message(g->playerList,NULL,B_CONSOLE,GRN"\nLa partie vas commencer dans : ");
-    sleep(sleep_delta);
-    broadcast_message(g->playerList,NULL,B_CONSOLE,"3 ");
-    sleep(sleep_delta);
-    broadcast_message(g->playerList,NULL,B_CONSOLE,"2 ");
-    sleep(sleep_delta);
-    broadcast_message(g->playerList,NULL,B_CONSOLE,"1 ");
-    sleep(sleep_delta);
-    broadcast_message(g->playerList,NULL,B_CONSOLE,"Go !\n\n"CRESET);
+    broadcast_game(g,NULL,B_CONSOLE,MSG_COUNTDOWN,NULL);
+    g->countdown_step = 3;
+    g->countdown_delay_ms = sleep_delta * 1000;
+    g->countdown_ms = now_ms() + g->countdown_delay_ms;
 }
 
-void print_lobbyState(Game* g){
-    if (g->state != LOBBY_STATE) return;
-    char msg[BUFSIZ] = "";
-    strcat(msg, "------ LOBBY ------\n");
-
-    // Ajout du nombre de joueurs
-    char temp[256]; // Buffer temporaire pour les ajouts
-    snprintf(temp, sizeof(temp), CYN "Nb Joueurs : %d\n" CRESET, g->playerList->count);
-    strcat(msg, temp);
-    // Ajout des joueurs
-    strcat(msg, MAG "Joueurs : ");
-    for (int i = 0; i < g->playerList->count; ++i) {
-        if (g->playerList->players[i]->ready) {
-            snprintf(temp, sizeof(temp), BMAG "%s " CRESET, g->playerList->players[i]->name);
+/**
+ * @brief Append the players of the table, the ready ones in bold, and the ready count.
+ */
+static void append_players(StrBuilder *sb, Game *g){
+    int slot;
+    PlayerSnapshot *snap = read_players(g->playerList,&slot);
+    SB_LIT(sb, CYN "Nb Joueurs : ");
+    sb_int(sb, snap->count);
+    SB_LIT(sb, "\n" CRESET MAG "Joueurs : ");
+    for (int i = 0; i < snap->count; ++i) {
+        if (snap->players[i]->ready) {
+            SB_LIT(sb, BMAG);
         } else {
-            snprintf(temp, sizeof(temp), MAG "%s " CRESET, g->playerList->players[i]->name);
+            SB_LIT(sb, MAG);
         }
-        strcat(msg, temp);
-    }
-    // Ajout d'un retour à la ligne
-    strcat(msg, "\n");
-    // Ajout du nombre de joueurs prêts
-    snprintf(temp, sizeof(temp), YEL "Nb prêt : [%d/%d]\n" CRESET,
-             get_ready_count(g->playerList), g->playerList->count);
-    strcat(msg, temp);
-    // Ajout de la fin du message
-    strcat(msg, "-------------------\n");
-    // Envoi du message
-    broadcast_message(g->playerList, NULL, B_CONSOLE, msg);
+        sb_str(sb, snap->players[i]->name);
+        SB_LIT(sb, " " CRESET);
+    }
+    SB_LIT(sb, "\n" YEL "Nb prêt : [");
+    sb_int(sb, get_ready_count(g->playerList));
+    SB_LIT(sb, "/");
+    sb_int(sb, snap->count);
+    SB_LIT(sb, "]\n" CRESET);
+    release_players(g->playerList,slot);
+}
+static void render_lobby(Game *g, StrBuilder *sb){
+    SB_LIT(sb, "------ LOBBY ------\n");
+    append_players(sb, g);
+    SB_LIT(sb, "-------------------\n");
+}
+static void render_game(Game *g, StrBuilder *sb){
+    SB_LIT(sb, "------ Partie en cours ------\n" BLU "Prochaine manche : ");
+    sb_int(sb, g->round);
+    SB_LIT(sb, "\n" CRESET);
+    append_players(sb, g);
+    //Statistiques :
+    SB_LIT(sb, RED "Meilleur round : ");
+    sb_int(sb, g->gameData->max_round_lvl);
+    SB_LIT(sb, "\n" CRESET RED "Ratio rounds gagné / rounds : ");
+    sb_int(sb, g->gameData->win_rounds);
+    SB_LIT(sb, "/");
+    sb_int(sb, g->gameData->rounds);
+    SB_LIT(sb, "\n" CRESET "-----------------------------\n");
+}
+void print_lobbyState(Game* g){
+    if (g->state != LOBBY_STATE) return;
+    char msg[BUFSIZ];
+    StrBuilder sb;
+    sb_init(&sb, msg, sizeof(msg));
+    render_lobby(g, &sb);
+    publish(g, NULL, B_CONSOLE, msg, sb.len);
 }
 void print_gameState(Game* g){
     if (g->state != GAME_STATE) return;
-    char msg[BUFSIZ] = "";
-    strcat(msg, "------ Partie en cours ------\n");
-
-    // Ajout du nombre de joueurs
-    char temp[256]; // Buffer temporaire pour les ajouts
-    //Niveau de la prochaine manche
-    snprintf(temp,sizeof (temp), BLU"Prochaine manche : %d\n"CRESET,g->round);
-    strcat(msg,temp);
-    //Nombre de joueurs
-    snprintf(temp, sizeof(temp), CYN "Nb Joueurs : %d\n" CRESET, g->playerList->count);
-    strcat(msg, temp);
-    // Ajout des joueurs
-    strcat(msg, MAG "Joueurs : ");
-    for (int i = 0; i < g->playerList->count; ++i) {
-        if (g->playerList->players[i]->ready) {
-            snprintf(temp, sizeof(temp), BMAG "%s " CRESET, g->playerList->players[i]->name);
-        } else {
-            snprintf(temp, sizeof(temp), MAG "%s " CRESET, g->playerList->players[i]->name);
-        }
-        strcat(msg, temp);
-    }
-    // Ajout d'un retour à la ligne
-    strcat(msg, "\n");
-    // Ajout du nombre de joueurs prêts
-    snprintf(temp, sizeof(temp), YEL "Nb prêt : [%d/%d]\n" CRESET,
-             get_ready_count(g->playerList), g->playerList->count);
-    strcat(msg, temp);
-    //Statistiques :
-    snprintf(temp,sizeof(temp),RED"Meilleur round : %d\n"CRESET,g->gameData->max_round_lvl);
-    strcat(msg,temp);
-    snprintf(temp,sizeof(temp),RED"Ratio rounds gagné / rounds : %d/%d\n"CRESET,g->gameData->win_rounds,g->gameData->rounds);
-    strcat(msg,temp);
-    // Ajout de la fin du message
-    strcat(msg, "-----------------------------\n");
-    // Envoi du message
-    broadcast_message(g->playerList, NULL, B_CONSOLE, msg);
-}
-void print_playState(Game* g){
-    if (g->state != PLAY_STATE) return;
+    char msg[BUFSIZ];
+    StrBuilder sb;
+    sb_init(&sb, msg, sizeof(msg));
+    render_game(g, &sb);
+    publish(g, NULL, B_CONSOLE, msg, sb.len);
+}
 
-    for (int i = 0; i < g->playerList->count; ++i) {
-        Player *p = g->playerList->players[i];
-        char msg[BUFSIZ] = "";
-        strcat(msg, "------ Manche en cours ------\n");
-
-        char temp[256]; // Buffer temporaire pour les ajouts
-        snprintf(temp,sizeof (temp), BLU"Manche : %d\n"CRESET,g->round); //Niveau de la manche
-        strcat(msg,temp);
-        snprintf(temp,sizeof(temp),MAG"Cartes : "); //Carte du joueur p
-        strcat(msg,temp);
-        for (int j = 0; j < g->round; ++j) {
-            if(p->cards[j] != 0){
-                snprintf(temp,sizeof(temp),"%d ",p->cards[j]);
-                strcat(msg,temp);
-            }
+#define PLAY_HEAD_SIZE 128
+#define PLAY_TAIL_SIZE (MAX_CARDS * 3 + 96) // "99," per card
+
+/**
+ * @brief Render the parts of the round screen shared by every player : the header and the board.
+ */
+static void render_play(Game *g, StrBuilder *h, StrBuilder *t){
+    SB_LIT(h, "------ Manche en cours ------\n" BLU "Manche : ");
+    sb_int(h, g->round);
+    SB_LIT(h, "\n" CRESET);
+
+    SB_LIT(t, YEL "Plateau : ");
+    format_board(t, g->board, g->round * g->playerList->count);
+    SB_LIT(t, "\n" CRESET "------------------------------\n");
+}
+/**
+ * @brief Send the round screen to a player, its hand between the shared parts.
+ */
+static void send_play(Player *p, const StrBuilder *h, const StrBuilder *t){
+    char msg[PLAY_HEAD_SIZE + PLAY_TAIL_SIZE + MAX_CARDS * 3 + 16];
+    StrBuilder sb;
+    sb_init(&sb, msg, sizeof(msg));
+    sb_append(&sb, h->buf, h->len);
+    SB_LIT(&sb, MAG "Cartes : "); //Carte du joueur p
+    Queue hand = p->hand;
+    while (!isEmpty(&hand)) {
+        sb_int(&sb, dequeue(&hand));
+        SB_LIT(&sb, " ");
+    }
+    SB_LIT(&sb, "\n" CRESET);
+    sb_append(&sb, t->buf, t->len);
+    send_raw(p, msg, sb.len);
+}
+/**
+ * @brief Send the round screen : the board is rendered once, only the hand differs between players.
+ * @param full Also send it to the players in delta mode, at the start of a round.
+ */
+void print_playState(Game* g, bool full){
+    if (g->state != PLAY_STATE) return;
+    char head[PLAY_HEAD_SIZE];
+    char tail[PLAY_TAIL_SIZE];
+    StrBuilder h, t;
+    sb_init(&h, head, sizeof(head));
+    sb_init(&t, tail, sizeof(tail));
+    render_play(g, &h, &t);
+
+    int slot;
+    PlayerSnapshot *snap = read_players(g->playerList,&slot);
+    for (int i = 0; i < snap->count; ++i) {
+        Player *p = snap->players[i];
+        if (!p->in_round) continue; // Seated after the start of the round
+        if (p->delta && !full) continue; // Gets print_playDelta instead
+        send_play(p, &h, &t);
+    }
+    release_players(g->playerList,slot);
+
+    // Spectators see the same screen, without any hand.
+    char screen[PLAY_HEAD_SIZE + PLAY_TAIL_SIZE];
+    StrBuilder sb;
+    sb_init(&sb, screen, sizeof(screen));
+    sb_append(&sb, head, h.len);
+    sb_append(&sb, tail, t.len);
+    spectators_publish(g->spectators, screen, sb.len);
+}
+/**
+ * @brief Send what a card changed to the players in delta mode, in place of the whole round screen.
+ *
+ * Everyone gets the new board slot, the player of the card gets the card removed from its hand.
+ * The size of the update doesn't depend on the round.
+ *
+ * @param p Player of the card.
+ * @param slot Board slot of the card, from 0, -1 if the card was refused.
+ */
+void print_playDelta(Game *g, Player *p, int card, int slot){
+    char buffers[MSG_STYLES][MSG_SIZE];
+    const char *msgs[MSG_STYLES];
+    int lengths[MSG_STYLES];
+    if (slot >= 0) {
+        for (int style = 0; style < MSG_STYLES; ++style) {
+            msgs[style] = msg_render(buffers[style],MSG_SIZE,MSG_DELTA_BOARD,style,MSG_ARGS(ARG_D(slot + 1),ARG_D(card)),&lengths[style]);
+        }
+        int snap_slot;
+        PlayerSnapshot *snap = read_players(g->playerList,&snap_slot);
+        for (int i = 0; i < snap->count; ++i) {
+            Player *q = snap->players[i];
+            if (q->delta && q->in_round) send_raw(q, msgs[q->style], lengths[q->style]);
         }
-        strcat(msg,"\n"CRESET);
-        char* board_msg = format_board(g->board,(g->round*g->playerList->count));
-        snprintf(temp,sizeof(temp),YEL"Plateau : %s\n"CRESET,board_msg);
-        strcat(msg,temp);
-        free(board_msg);
-        strcat(msg, "------------------------------\n"); //Fin du message
-        send_p(p,msg);
+        release_players(g->playerList,snap_slot);
     }
-
+    if (p->delta) send_msg(p,MSG_DELTA_HAND,MSG_ARGS(ARG_D(card)));
+}
+/**
+ * @brief Send the screen of the current state to a single player, on its request.
+ */
+void send_state(Game *g, Player *p){
+    char msg[BUFSIZ];
+    StrBuilder sb;
+    sb_init(&sb, msg, sizeof(msg));
+    switch (g->state) {
+        case LOBBY_STATE:
+            render_lobby(g, &sb);
+            break;
+        case GAME_STATE:
+            render_game(g, &sb);
+            break;
+        case PLAY_STATE:
+            if (p->in_round) {
+                char head[PLAY_HEAD_SIZE];
+                char tail[PLAY_TAIL_SIZE];
+                StrBuilder h, t;
+                sb_init(&h, head, sizeof(head));
+                sb_init(&t, tail, sizeof(tail));
+                render_play(g, &h, &t);
+                send_play(p, &h, &t);
+            }
+            return;
+        default:
+            return;
+    }
+    send_raw(p, msg, sb.len);
+}
+/**
+ * @brief Send the profile of a player, read from the profile store.
+ * @param name Player of the profile, the asker if NULL.
+ */
+void print_profile(Player *p, const char *name){
+    if (name == NULL) name = p->name;
+    Profile profile;
+    if (profile_get(name, &profile) == -1) {
+        send_msg(p,MSG_NO_PROFILE,MSG_ARGS(ARG_S(name)));
+        return;
+    }
+    char msg[BUFSIZ];
+    StrBuilder sb;
+    sb_init(&sb, msg, sizeof(msg));
+    SB_LIT(&sb, "------ Profil de ");
+    sb_str(&sb, profile.name);
+    SB_LIT(&sb, " ------\n" BLU "Manches jouées : ");
+    sb_int(&sb, (int)profile.rounds);
+    SB_LIT(&sb, " (gagnées : ");
+    sb_int(&sb, (int)profile.win_rounds);
+    SB_LIT(&sb, ")\n" CRESET YEL "Meilleur niveau : ");
+    sb_int(&sb, (int)profile.best_level);
+    SB_LIT(&sb, "\n" CRESET MAG "Cartes jouées : ");
+    sb_int(&sb, (int)profile.cards);
+    SB_LIT(&sb, ", cartes perdantes : ");
+    sb_int(&sb, (int)profile.losing_cards);
+    char line[128];
+    int len = snprintf(line, sizeof(line), " (%.1f%%)\n" CRESET CYN "Temps de réaction p50 / p90 / p99 : %.3f / %.3f / %.3f s\n" CRESET,
+                       profile.cards > 0 ? 100.0 * profile.losing_cards / profile.cards : 0.0,
+                       hist_percentile(&profile.reaction, 50) / 1e9,
+                       hist_percentile(&profile.reaction, 90) / 1e9,
+                       hist_percentile(&profile.reaction, 99) / 1e9);
+    sb_append(&sb, line, len);
+    SB_LIT(&sb, "------------------------------\n");
+    send_raw(p, msg, sb.len);
 }
 void print_classement(Game* g, Player* p){
     int line;
@@ -490,10 +980,10 @@ void print_classement(Game* g, Player* p){
         // Utilisation de largeurs fixes avec padding
         broadcast_message(g->playerList,p,0,"%-5d " CYN "%-*s " MAG "%-*s " BLU "%-*s " YEL "%-*s\n" CRESET,
                           i+1, width_nbJoueurs, nbJoueurs, width_mancheMax, mancheMax, width_joueurs, joueurs, width_date, date);
-        free(result[i]);
+        mem_free(MEM_STATS,result[i]);
     }
 
-    free(result);
+    mem_free(MEM_STATS,result);
     broadcast_message(g->playerList,p,0,"---------------------------------------------------------------------\n");
 }
 
@@ -13,16 +13,29 @@
 #include "utils.h"
 #include "queue.h"
 #include "statsManager.h"
+#include "profiles.h"
+#include "analytics.h"
+#include "spectators.h"
+#include "mailbox.h"
+#include "trace.h"
+#include "memstats.h"
 #include "ANSI-color-codes.h"
 
-#define STAT_FILE_DL GRN"\nLe fichier de statistiques est disponible. \nNom du fichier : %s.pdf \nPour le récupérer, utiliser la commande : getfile %s.pdf sur le port du serveur + 1\n\n"CRESET
 #define DEFAULT_ROUND 1
+#define MAX_CARDS 99 // Cards of the deck, the most a round can deal
 #define NO_CARD 1
 #define WRONG_CARD 2
 #define ROUND_WIN 3
 #define LOBBY_STATE 0
 #define GAME_STATE 1
 #define PLAY_STATE 2
+#define ROOM_TICK_MAX 32 // Messages handled in one tick before flushing
+#define STATE_RENDER_MS 100 // Minimum delay between two renders of the lobby or game state
+#define SESSION_GRACE 30 // Seconds a seat is held for a player whose connection was lost
+#define REPLY_POLL_MS 1000 // A client thread waiting for the executor checks at this period that it still runs
+
+struct Game;
+typedef void (*room_handler)(struct Game *g, RoomMsg *msg);
 
 /**
  * @struct Game
@@ -30,23 +43,52 @@
  *
  * This structure holds all the necessary information to manage the state of the game, including the current round,
  * the list of players, the game board, the number of played cards, the queue of cards to be played, and the current game state.
- * It also contains a read-write lock to ensure thread-safe access to the game state.
+ * The state is owned by the executor thread of the table : other threads post messages in its mailbox.
  */
-typedef struct {
+typedef struct Game {
+    int id; // Unique id of the game table
+    int size; // Seats wanted by the matchmaking, 0 for any. Protected by the matchmaker mutex
+    atomic_int lobby_players; // Players seated while in the lobby, -1 otherwise : published by the executor for the matchmaker
+    int reserved; // Seats given by the matchmaker, not yet accepted by the executor. Protected by the matchmaker mutex
     int round; // Level of the actual round
     PlayerList *playerList; // List of Players
-    int *board; // Int array, representing the cards played
+    int board[MAX_CARDS]; // Cards played in the round, 0 for a free slot. Kept for the table lifetime
     int played_cards_count; // Number of played card
     Queue *cards_queue; // Queue of the card to be played, sorted
+    Player *owner[QUEUE_MAX_CARD + 1]; // Holder of each card of the round, NULL if played or not dealt
     int state; // Actual state of the game (GAME,LOBBY or PLAY)
     GameData *gameData; // Structure to hold and generate stats
-    time_t startingTime; // Timer representing le beginning of the round
-    pthread_rwlock_t mutex; // Mutex to ensure reading et writting acces
+    uint64_t start_ns; // Monotonic time of the beginning of the round, in ns
+    Spectators *spectators; // Read-only viewers of the table
+    Mailbox mailbox; // Messages for the executor
+    pthread_t executor; // Thread owning the game state
+    room_handler handler; // Called by the executor for each message, NULL when stopped
+    atomic_bool stopped; // The executor ended, no message is answered anymore
+    OutputTick tick; // Output of the executor, flushed once per tick
+    bool state_dirty; // The state screen changed since its last render
+    long long last_render_ms; // Monotonic time of the last state render
+    int countdown_step; // Next step of the countdown, 0 for "Go", -1 if none
+    int countdown_delay_ms; // Delay between two steps
+    long long countdown_ms; // Monotonic time of the next step
+    int nb_held; // Seats held for disconnected players
 } Game;
 
 Game *create_game(PlayerList *pl);
 void free_game(Game* g);
 
+int start_executor(Game *g, room_handler handler);
+void stop_executor(Game *g);
+void post_room(Game *g, int type, Player *p, const char *cmd);
+void post_disconnect(Game *g, int type, Player *p, int fd);
+void request_state_render(Game *g);
+
+void hold_player(Game *g, Player *p);
+Player *resume_player(Game *g, int fd, const char *token);
+Player *resume_session(Game *g, int fd, const char *token);
+Player *request_seat(Game *g, int fd, const char *name, int admin);
+
+void broadcast_game(Game *g, Player *exclude, int params, int id, const MsgArg *args);
+
 int start_game(Game* g,Player *p);
 int start_round(Game *g, Player *p);
 void end_round(Game *g, int win);
@@ -63,7 +105,10 @@ void countdown(Game *g, int sleep_delta);
 
 void print_lobbyState(Game* g);
 void print_gameState(Game* g);
-void print_playState(Game* g);
+void print_playState(Game* g, bool full);
+void print_playDelta(Game *g, Player *p, int card, int slot);
+void send_state(Game *g, Player *p);
+void print_profile(Player *p, const char *name);
 void print_classement(Game* g, Player* p);
 
 
@@ -0,0 +1,208 @@
+//
+// Created by erwan on 19/10/2026.
+//
+
+#include <stdio.h>
+#include <stdatomic.h>
+#include <time.h>
+#include "analytics.h"
+#include "utils.h"
+#include "ANSI-color-codes.h"
+
+#define SLOT_RESETTING (-1)
+#define HOT_CARDS 5 // Losing cards shown in the report
+
+/**
+ * @brief Events of all tables during ANALYTICS_BUCKET_S seconds.
+ *
+ * Buckets form a ring over the last hour, a bucket is emptied by the first event of its new period.
+ * Counters are relaxed atomics : the event feed never takes a lock.
+ */
+typedef struct {
+    _Atomic long long slot; // Period of the counters, or SLOT_RESETTING
+    atomic_uint rounds[ANALYTICS_LEVELS];
+    atomic_uint wins[ANALYTICS_LEVELS];
+    atomic_ullong round_ns; // Duration of the rounds
+    atomic_uint cards[ANALYTICS_CARDS];
+    atomic_uint losing[ANALYTICS_CARDS];
+    atomic_ullong tables; // Active tables, bit table % 64
+} Bucket;
+
+static Bucket ring[ANALYTICS_BUCKETS]; // Zeroed : empty counters of the period 0
+static const int window_minutes[ANALYTICS_WINDOWS] = {1, 5, 60};
+
+static long long now_slot(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts); // No syscall, a few ns
+    return (long long)ts.tv_sec / ANALYTICS_BUCKET_S;
+}
+
+/**
+ * @brief Bucket of the current period, emptied first if it still holds an older one.
+ *
+ * The thread that wins the reset clears the counters. The others never wait for it : their
+ * event is dropped, like an event coming after the bucket was reused for a newer period.
+ *
+ * @return The bucket, or NULL if the event is dropped.
+ */
+static Bucket *current_bucket(void) {
+    long long slot = now_slot();
+    Bucket *b = &ring[slot % ANALYTICS_BUCKETS];
+    long long seen = atomic_load_explicit(&b->slot, memory_order_acquire);
+    while (seen != slot) {
+        if (seen == SLOT_RESETTING) return NULL; // Being emptied by another thread, the event is dropped
+        if (seen > slot) return NULL; // Already reused for a newer period, the event is dropped
+        if (atomic_compare_exchange_weak_explicit(&b->slot, &seen, SLOT_RESETTING,
+                                                  memory_order_acquire, memory_order_acquire)) {
+            for (int i = 0; i < ANALYTICS_LEVELS; ++i) {
+                atomic_store_explicit(&b->rounds[i], 0, memory_order_relaxed);
+                atomic_store_explicit(&b->wins[i], 0, memory_order_relaxed);
+            }
+            for (int i = 0; i < ANALYTICS_CARDS; ++i) {
+                atomic_store_explicit(&b->cards[i], 0, memory_order_relaxed);
+                atomic_store_explicit(&b->losing[i], 0, memory_order_relaxed);
+            }
+            atomic_store_explicit(&b->round_ns, 0, memory_order_relaxed);
+            atomic_store_explicit(&b->tables, 0, memory_order_relaxed);
+            atomic_store_explicit(&b->slot, slot, memory_order_release);
+            return b;
+        }
+    }
+    return b;
+}
+
+/**
+ * @brief Mark a table as active, at the start of its rounds.
+ */
+void analytics_table(int table) {
+    Bucket *b = current_bucket();
+    if (b == NULL) return;
+    atomic_fetch_or_explicit(&b->tables, 1ULL << (table % 64), memory_order_relaxed);
+}
+
+/**
+ * @brief Count a round at its end.
+ * @param duration_ns Time from the start of the round to its end.
+ */
+void analytics_round(int table, int level, bool win, uint64_t duration_ns) {
+    Bucket *b = current_bucket();
+    if (b == NULL) return;
+    int l = level < 1 ? 0 : (level > ANALYTICS_LEVELS ? ANALYTICS_LEVELS - 1 : level - 1);
+    atomic_fetch_add_explicit(&b->rounds[l], 1, memory_order_relaxed);
+    if (win) atomic_fetch_add_explicit(&b->wins[l], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&b->round_ns, duration_ns, memory_order_relaxed);
+    atomic_fetch_or_explicit(&b->tables, 1ULL << (table % 64), memory_order_relaxed);
+}
+
+void analytics_card(int card) {
+    if (card < 0 || card >= ANALYTICS_CARDS) return;
+    Bucket *b = current_bucket();
+    if (b == NULL) return;
+    atomic_fetch_add_explicit(&b->cards[card], 1, memory_order_relaxed);
+}
+
+void analytics_losing_card(int card) {
+    if (card < 0 || card >= ANALYTICS_CARDS) return;
+    Bucket *b = current_bucket();
+    if (b == NULL) return;
+    atomic_fetch_add_explicit(&b->losing[card], 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Sums of the buckets of a window.
+ */
+typedef struct {
+    unsigned int rounds[ANALYTICS_LEVELS];
+    unsigned int wins[ANALYTICS_LEVELS];
+    unsigned int nb_rounds;
+    unsigned long long round_ns;
+    unsigned int cards[ANALYTICS_CARDS];
+    unsigned int losing[ANALYTICS_CARDS];
+    unsigned long long tables;
+} Window;
+
+/**
+ * @brief Add up the buckets of the last minutes, a bucket being reset meanwhile may be partly counted.
+ */
+static void read_window(Window *w, long long slot, int minutes) {
+    long long first = slot - (long long)minutes * 60 / ANALYTICS_BUCKET_S + 1;
+    *w = (Window){0};
+    for (int i = 0; i < ANALYTICS_BUCKETS; ++i) {
+        Bucket *b = &ring[i];
+        long long s = atomic_load_explicit(&b->slot, memory_order_acquire);
+        if (s < first || s > slot) continue;
+        for (int l = 0; l < ANALYTICS_LEVELS; ++l) {
+            w->rounds[l] += atomic_load_explicit(&b->rounds[l], memory_order_relaxed);
+            w->wins[l] += atomic_load_explicit(&b->wins[l], memory_order_relaxed);
+        }
+        for (int c = 0; c < ANALYTICS_CARDS; ++c) {
+            w->cards[c] += atomic_load_explicit(&b->cards[c], memory_order_relaxed);
+            w->losing[c] += atomic_load_explicit(&b->losing[c], memory_order_relaxed);
+        }
+        w->round_ns += atomic_load_explicit(&b->round_ns, memory_order_relaxed);
+        w->tables |= atomic_load_explicit(&b->tables, memory_order_relaxed);
+    }
+    for (int l = 0; l < ANALYTICS_LEVELS; ++l) {
+        w->nb_rounds += w->rounds[l];
+    }
+}
+
+/**
+ * @brief Write the report of the last 1, 5 and 60 minutes : active tables, rounds, win rate per level
+ *        and the cards that lost the most rounds.
+ * @return The length of the report.
+ */
+int analytics_report(char *buffer, int size) {
+    Window windows[ANALYTICS_WINDOWS];
+    StrBuilder sb;
+    sb_init(&sb, buffer, size);
+    long long slot = now_slot();
+    for (int i = 0; i < ANALYTICS_WINDOWS; ++i) {
+        read_window(&windows[i], slot, window_minutes[i]);
+    }
+
+    char line[128];
+    SB_LIT(&sb, "------ Analytique (1 min | 5 min | 60 min) ------\n" CYN "Tables actives :");
+    for (int i = 0; i < ANALYTICS_WINDOWS; ++i) {
+        SB_LIT(&sb, " ");
+        sb_int(&sb, __builtin_popcountll(windows[i].tables));
+    }
+    SB_LIT(&sb, "\n" CRESET BLU "Manches :");
+    for (int i = 0; i < ANALYTICS_WINDOWS; ++i) {
+        SB_LIT(&sb, " ");
+        sb_int(&sb, (int)windows[i].nb_rounds);
+    }
+    SB_LIT(&sb, "\nDurée moyenne d'une manche :");
+    for (int i = 0; i < ANALYTICS_WINDOWS; ++i) {
+        double avg = windows[i].nb_rounds > 0 ? (double)windows[i].round_ns / windows[i].nb_rounds / 1e9 : 0.0;
+        sb_append(&sb, line, snprintf(line, sizeof(line), " %.2f s", avg));
+    }
+    SB_LIT(&sb, "\n" CRESET GRN "Manches gagnées par niveau :\n");
+    for (int l = 0; l < ANALYTICS_LEVELS; ++l) {
+        if (windows[ANALYTICS_WINDOWS - 1].rounds[l] == 0) continue; // Nothing in the last hour
+        sb_append(&sb, line, snprintf(line, sizeof(line), "  Niveau %d%s :", l + 1, l == ANALYTICS_LEVELS - 1 ? "+" : ""));
+        for (int i = 0; i < ANALYTICS_WINDOWS; ++i) {
+            SB_LIT(&sb, " ");
+            sb_int(&sb, (int)windows[i].wins[l]);
+            SB_LIT(&sb, "/");
+            sb_int(&sb, (int)windows[i].rounds[l]);
+        }
+        SB_LIT(&sb, "\n");
+    }
+
+    // Cards that lost the most rounds in the last hour
+    const Window *hour = &windows[ANALYTICS_WINDOWS - 1];
+    bool shown[ANALYTICS_CARDS] = {false};
+    SB_LIT(&sb, CRESET RED "Cartes perdantes (60 min) :");
+    for (int k = 0; k < HOT_CARDS; ++k) {
+        int best = -1;
+        for (int c = 0; c < ANALYTICS_CARDS; ++c) {
+            if (!shown[c] && hour->losing[c] > 0 && (best == -1 || hour->losing[c] > hour->losing[best])) best = c;
+        }
+        if (best == -1) break;
+        shown[best] = true;
+        sb_append(&sb, line, snprintf(line, sizeof(line), " %d (%u/%u)", best, hour->losing[best], hour->cards[best]));
+    }
+    SB_LIT(&sb, "\n" CRESET "-------------------------------------------------\n");
+    return sb.len;
+}
@@ -0,0 +1,23 @@
+//
+// Created by erwan on 19/10/2026.
+//
+
+#ifndef THEMIND_ANALYTICS_H
+#define THEMIND_ANALYTICS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ANALYTICS_BUCKET_S 10 // Time covered by a bucket of the windows
+#define ANALYTICS_BUCKETS 360 // 60 minutes
+#define ANALYTICS_LEVELS 10 // Round levels counted apart, the higher ones with the last
+#define ANALYTICS_CARDS 100
+#define ANALYTICS_WINDOWS 3 // 1, 5 and 60 minutes
+
+void analytics_table(int table);
+void analytics_round(int table, int level, bool win, uint64_t duration_ns);
+void analytics_card(int card);
+void analytics_losing_card(int card);
+int analytics_report(char *buffer, int size);
+
+#endif //THEMIND_ANALYTICS_H
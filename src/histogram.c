@@ -0,0 +1,74 @@
+//
+// Created by erwan on 19/10/2026.
+//
+
+#include <string.h>
+#include "histogram.h"
+
+static int bucket_of(uint64_t value) {
+    if (value < HIST_SUB) return (int)value; // First group is exact
+    int magnitude = 63 - __builtin_clzll(value);
+    if (magnitude >= HIST_MAX_MAGNITUDE) return HIST_BUCKETS - 1;
+    int group = magnitude - HIST_SUB_BITS + 1;
+    int sub = (int)(value >> (magnitude - HIST_SUB_BITS)) - HIST_SUB;
+    return group * HIST_SUB + sub;
+}
+
+/**
+ * @brief Middle of a bucket, the value reported for everything recorded in it.
+ */
+static uint64_t bucket_value(int bucket) {
+    int group = bucket / HIST_SUB;
+    if (group == 0) return (uint64_t)bucket;
+    uint64_t lower = (uint64_t)(HIST_SUB + bucket % HIST_SUB) << (group - 1);
+    return lower + ((1ULL << (group - 1)) >> 1);
+}
+
+void hist_reset(Histogram *h) {
+    memset(h, 0, sizeof(*h));
+}
+
+void hist_record(Histogram *h, uint64_t value) {
+    h->counts[bucket_of(value)]++;
+    h->total++;
+    h->sum += value;
+    if (value > h->max) h->max = value;
+}
+
+/**
+ * @brief Add the values of src to dst.
+ */
+void hist_merge(Histogram *dst, const Histogram *src) {
+    if (src->total == 0) return;
+    for (int i = 0; i < HIST_BUCKETS; ++i) {
+        dst->counts[i] += src->counts[i];
+    }
+    dst->total += src->total;
+    dst->sum += src->sum;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+/**
+ * @brief Value under which percent % of the recorded values are.
+ * @param percent Between 0 and 100.
+ * @return The value, within the precision of its bucket, 0 if the histogram is empty.
+ */
+uint64_t hist_percentile(const Histogram *h, double percent) {
+    if (h->total == 0) return 0;
+    uint64_t rank = (uint64_t)(percent / 100.0 * (double)h->total + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > h->total) rank = h->total;
+    uint64_t seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; ++i) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            uint64_t value = bucket_value(i);
+            return value < h->max ? value : h->max;
+        }
+    }
+    return h->max;
+}
+
+double hist_mean(const Histogram *h) {
+    return h->total > 0 ? (double)h->sum / (double)h->total : 0.0;
+}
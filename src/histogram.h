@@ -0,0 +1,34 @@
+//
+// Created by erwan on 19/10/2026.
+//
+
+#ifndef THEMIND_HISTOGRAM_H
+#define THEMIND_HISTOGRAM_H
+
+#include <stdint.h>
+
+#define HIST_SUB_BITS 3 // Linear buckets per power of two : 2^3, values known within 1/8
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_MAX_MAGNITUDE 38 // Values up to 2^38 ns (~4.5 min), larger ones go in the last bucket
+#define HIST_BUCKETS ((HIST_MAX_MAGNITUDE - HIST_SUB_BITS + 1) * HIST_SUB)
+
+/**
+ * @brief Log-bucketed histogram of durations in nanoseconds, HDR style.
+ *
+ * Each power of two is split in HIST_SUB buckets, so the relative error doesn't depend on the value.
+ * Histograms have the same buckets, they are merged by adding the counts.
+ */
+typedef struct {
+    uint32_t counts[HIST_BUCKETS];
+    uint64_t total; // Recorded values
+    uint64_t sum; // Sum of the values, for the mean
+    uint64_t max;
+} Histogram;
+
+void hist_reset(Histogram *h);
+void hist_record(Histogram *h, uint64_t value);
+void hist_merge(Histogram *dst, const Histogram *src);
+uint64_t hist_percentile(const Histogram *h, double percent);
+double hist_mean(const Histogram *h);
+
+#endif //THEMIND_HISTOGRAM_H
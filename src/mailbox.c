@@ -0,0 +1,122 @@
+//
+// Created by erwan on 19/10/2026.
+//
+
+#include <stdio.h>
+#include <errno.h>
+#include <sched.h>
+#include <time.h>
+#include "mailbox.h"
+
+void mailbox_init(Mailbox *mb) {
+    atomic_store(&mb->stub.next, NULL);
+    atomic_store(&mb->head, &mb->stub);
+    mb->tail = &mb->stub;
+    sem_init(&mb->count, 0, 0);
+}
+
+/**
+ * @brief Free the messages left in the mailbox.
+ * @note No producer must push anymore.
+ */
+void mailbox_destroy(Mailbox *mb) {
+    RoomMsg *msg;
+    while ((msg = mailbox_wait(mb, 0)) != NULL) {
+        mem_free(MEM_NETWORK, msg);
+    }
+    sem_destroy(&mb->count);
+}
+
+/**
+ * @brief Allocate a message.
+ * @param cmd Command text, may be NULL.
+ * @return The message, or NULL on allocation failure.
+ */
+RoomMsg *room_msg(int type, Player *p, const char *cmd) {
+    RoomMsg *msg = mem_malloc(MEM_NETWORK, sizeof(RoomMsg));
+    if (msg == NULL) {
+        perror("ERROR : message allocation");
+        return NULL;
+    }
+    msg->type = type;
+    msg->p = p;
+    msg->gen = p != NULL ? atomic_load(&p->gen) : 0;
+    msg->fd = -1;
+    msg->admin = 0;
+    msg->reply = NULL;
+    snprintf(msg->cmd, sizeof(msg->cmd), "%s", cmd ? cmd : "");
+    return msg;
+}
+
+static void push(Mailbox *mb, RoomMsg *msg) {
+    atomic_store_explicit(&msg->next, NULL, memory_order_relaxed);
+    RoomMsg *prev = atomic_exchange_explicit(&mb->head, msg, memory_order_acq_rel);
+    atomic_store_explicit(&prev->next, msg, memory_order_release);
+}
+
+/**
+ * @brief Post a message, can be called from any thread.
+ */
+void mailbox_push(Mailbox *mb, RoomMsg *msg) {
+    push(mb, msg);
+    sem_post(&mb->count);
+}
+
+/**
+ * @brief Pop a message.
+ * @return The message, or NULL if the mailbox is empty or a producer is between its exchange and its link.
+ */
+static RoomMsg *pop(Mailbox *mb) {
+    RoomMsg *tail = mb->tail;
+    RoomMsg *next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    if (tail == &mb->stub) {
+        if (next == NULL) return NULL;
+        mb->tail = next;
+        tail = next;
+        next = atomic_load_explicit(&next->next, memory_order_acquire);
+    }
+    if (next != NULL) {
+        mb->tail = next;
+        return tail;
+    }
+    if (tail != atomic_load_explicit(&mb->head, memory_order_acquire)) return NULL;
+    push(mb, &mb->stub); // Last message : the stub takes its place
+    next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    if (next != NULL) {
+        mb->tail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Wait for the next message, consumer side only.
+ * @param timeout_ms Maximum wait in milliseconds, -1 to wait without limit.
+ * @return The message, to be freed with mem_free(MEM_NETWORK, ...), or NULL on timeout.
+ */
+RoomMsg *mailbox_wait(Mailbox *mb, int timeout_ms) {
+    int res;
+    if (timeout_ms < 0) {
+        while ((res = sem_wait(&mb->count)) == -1 && errno == EINTR);
+    } else if (timeout_ms == 0) {
+        res = sem_trywait(&mb->count);
+    } else {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while ((res = sem_timedwait(&mb->count, &deadline)) == -1 && errno == EINTR);
+    }
+    if (res == -1) return NULL;
+
+    // The message is counted, it may only wait for its producer to link it.
+    RoomMsg *msg;
+    while ((msg = pop(mb)) == NULL) {
+        sched_yield();
+    }
+    return msg;
+}
@@ -0,0 +1,63 @@
+//
+// Created by erwan on 19/10/2026.
+//
+
+#ifndef THEMIND_MAILBOX_H
+#define THEMIND_MAILBOX_H
+
+#include <stdatomic.h>
+#include <semaphore.h>
+#include "playersRessources.h"
+
+#define ROOM_JOIN 0 // Connection given a seat by the matchmaker, accepted or rejected by the executor
+#define ROOM_COMMAND 1 // Command sent by a player
+#define ROOM_LEAVE 2 // Player left, its seat is freed
+#define ROOM_STOP 3 // Stop the executor
+#define ROOM_DROP 4 // Connection lost, the seat may be held
+#define ROOM_RESUME 5 // Reconnection with a session token
+#define ROOM_SHUTDOWN 6 // Server shutdown, the players are told and disconnected
+#define ROOM_CMD_SIZE 256 // Longer commands are truncated
+
+/**
+ * @brief Answer of the executor to a ROOM_JOIN or a ROOM_RESUME, waited by the client thread.
+ */
+typedef struct {
+    sem_t done;
+    Player *player; // Seated or resumed player, NULL if the seat is refused or the token unknown
+} RoomReply;
+
+/**
+ * @brief Message posted to the executor of a table.
+ */
+typedef struct RoomMsg {
+    _Atomic(struct RoomMsg *) next;
+    int type; // ROOM_JOIN, ROOM_COMMAND, ROOM_LEAVE, ROOM_STOP, ROOM_DROP, ROOM_RESUME or ROOM_SHUTDOWN
+    Player *p; // Sender, owned by the table
+    unsigned int gen; // Generation of p when posted, the message is dropped if its slot was reused
+    char cmd[ROOM_CMD_SIZE]; // Command text for ROOM_COMMAND, name for ROOM_JOIN, session token for ROOM_RESUME
+    int fd; // Connection of the sender, for ROOM_JOIN, ROOM_DROP and ROOM_RESUME
+    int admin; // For ROOM_JOIN, the connection comes from the server host
+    RoomReply *reply; // For ROOM_JOIN and ROOM_RESUME
+} RoomMsg;
+
+/**
+ * @struct Mailbox
+ * @brief Lock-free multi-producer single-consumer queue (Vyukov intrusive queue).
+ *
+ * Producers push with one atomic exchange, the consumer pops without atomic read-modify-write.
+ * A semaphore counts the messages so that the consumer sleeps while the mailbox is empty.
+ */
+typedef struct {
+    _Atomic(RoomMsg *) head; // Last pushed message, producers side
+    RoomMsg *tail; // Next message to pop, consumer side
+    RoomMsg stub;
+    sem_t count;
+} Mailbox;
+
+void mailbox_init(Mailbox *mb);
+void mailbox_destroy(Mailbox *mb);
+RoomMsg *room_msg(int type, Player *p, const char *cmd);
+void mailbox_push(Mailbox *mb, RoomMsg *msg);
+RoomMsg *mailbox_wait(Mailbox *mb, int timeout_ms);
+
+#endif //THEMIND_MAILBOX_H
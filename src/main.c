@@ -3,45 +3,84 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <pthread.h>
 #include <signal.h>
 #include <errno.h>
+#include <arpa/inet.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <poll.h>
 #include "playersRessources.h"
 #include "ANSI-color-codes.h"
 #include "Game.h"
+#include "matchmaking.h"
 
-#define MAX_PLAYERS 4
-#define SERVER_FULL_MSG "Le serveur est plein. Veuillez réessayer plus tard.\n"
-#define GAME_STARTED_MSG "Une partie est déja en cours. Veuillez réessayer plus tard.\n"
 #define PDF_DIR "./pdf"
+#define DL_NOT_FOUND "Erreur : fichier non trouvé\n"
+#define DL_INVALID "Commande invalide\n"
 #define ROBOTIA_dir "../robot/TheMindRobot"
+#define CONN_POOL_SIZE 64 // Connections being handed to their client thread at once
+#define HANDSHAKE_POLL_MS 1000 // A client thread waiting for the first line checks the shutdown at this period
 /**
  * @brief Structure containing arguments for a player management thread.
  */
 typedef struct {
-    Player *p;
-    Game  *game;
+    int socket_fd;
+    int admin; // Connected from the server host
+    Matchmaker *mm;
 } ClientThreadArgs;
 /**
  * @brief Structure containing arguments for a listener connection management thread.
  */
 typedef struct{
     int listen_fd;
-    Game *game;
+    Matchmaker *mm;
 } ListentThreadArgs;
 
 volatile bool keepalive = true; // Boolean for managing listening et downloading thread.
-pthread_cond_t keepalive_cond;
-pthread_mutex_t keepalive_mutex;
 int s_port; // Global variable listening port
+Matchmaker *matchmaker; // Tables of the server
+atomic_int nb_clients = 0; // Running client threads
+
+// Preallocated arguments of the client threads, a slot is free again once its thread started.
+static ClientThreadArgs conn_slots[CONN_POOL_SIZE];
+static ClientThreadArgs *free_conns[CONN_POOL_SIZE];
+static int nb_free_conns = -1; // -1 until the first use
+static pthread_mutex_t conn_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Take a free connection slot.
+ * @return The slot, or NULL if every slot is in use.
+ */
+static ClientThreadArgs *acquire_conn(void){
+    pthread_mutex_lock(&conn_mutex);
+    if(nb_free_conns == -1){
+        nb_free_conns = 0;
+        for (int i = CONN_POOL_SIZE - 1; i >= 0; --i) {
+            free_conns[nb_free_conns++] = &conn_slots[i];
+        }
+    }
+    ClientThreadArgs *args = nb_free_conns > 0 ? free_conns[--nb_free_conns] : NULL;
+    pthread_mutex_unlock(&conn_mutex);
+    return args;
+}
+
+static void release_conn(ClientThreadArgs *args){
+    pthread_mutex_lock(&conn_mutex);
+    free_conns[nb_free_conns++] = args;
+    pthread_mutex_unlock(&conn_mutex);
+}
 
 /**
  * @brief Start robot program, the robot quit after the end of the game.
  * @param robot_name Robot's name.
+ * @param table Table joined by the robot.
  */
-void start_robot(char* robot_name){
+void start_robot(char* robot_name, int table){
     pid_t pid = fork();
     if(pid == -1) {
         perror("fork");
@@ -49,11 +88,36 @@ void start_robot(char* robot_name){
     } else if (pid == 0) {
         char port_str[6];
         snprintf(port_str,sizeof(port_str),"%d",s_port);
-        execl(ROBOTIA_dir,ROBOTIA_dir,port_str,"127.0.0.1",robot_name,"0",NULL);
+        char table_str[12];
+        snprintf(table_str,sizeof(table_str),"%d",table);
+        execl(ROBOTIA_dir,ROBOTIA_dir,"-t",table_str,port_str,"127.0.0.1",robot_name,"0",NULL);
         perror("execl");
         exit(EXIT_FAILURE);
     }
 }
+/**
+ * @brief Name of the trace span of a command.
+ * @param code Command code returned by hash_cmd.
+ */
+static const char *command_span(int code){
+    switch (code) {
+        case READY : return "cmd:ready";
+        case UNREADY : return "cmd:unready";
+        case START : return "cmd:start";
+        case CARD : return "cmd:card";
+        case STOP : return "cmd:stop";
+        case ROBOT_ADD : return "cmd:addrobot";
+        case MEMSTATS : return "cmd:memstats";
+        case ANALYTICS : return "cmd:analytics";
+        case COLOR :
+        case NO_COLOR : return "cmd:color";
+        case DELTA :
+        case NO_DELTA : return "cmd:delta";
+        case STATE : return "cmd:state";
+        case PROFILE : return "cmd:profile";
+        default: return "cmd:other";
+    }
+}
 /**
  * @brief Handles a command sent by a player.
  *
@@ -63,43 +127,47 @@ void start_robot(char* robot_name){
  */
 void handle_command(const char* cmd, Game *g, Player *p){
 //    printf("%s : %s\n",p->name,cmd);
-    switch (hash_cmd(cmd)) {
+    TRACE_BEGIN(span);
+    int code = hash_cmd(cmd);
+    switch (code) {
         case READY :
             if(g->state == LOBBY_STATE || g->state == GAME_STATE) {
                 if(set_ready_player(g,p,1) == -2)
-                    send_p(p,RED"La partie est déjà en cours\n"CRESET);
-            } else send_p(p,RED"La partie est déjà en cours\n"CRESET);
+                    send_msg(p,MSG_GAME_RUNNING,NULL);
+            } else send_msg(p,MSG_GAME_RUNNING,NULL);
             break;
         case UNREADY :
             if(g->state == LOBBY_STATE || g->state == GAME_STATE) {
                 if(set_ready_player(g,p,0) == -2)
-                    send_p(p,RED"La partie est déjà en cours\n"CRESET);
+                    send_msg(p,MSG_GAME_RUNNING,NULL);
 
-            } else send_p(p,RED"La partie est déjà en cours\n"CRESET);
+            } else send_msg(p,MSG_GAME_RUNNING,NULL);
             break;
         case START:
             if(g->state == LOBBY_STATE) {
                 if (start_game(g,p) == -1) // Start game
-                    send_p(p, RED"Tous les joueurs ne sont pas prêt !\n"CRESET);
+                    send_msg(p,MSG_NOT_READY,NULL);
             } else if(g->state == GAME_STATE){
                 if(start_round(g,p) == -1) // Start round
-                    send_p(p,RED"Tous les joueurs ne sont pas prêt !\n"CRESET);
+                    send_msg(p,MSG_NOT_READY,NULL);
             } else if(g->state == PLAY_STATE){
-                send_p(p,RED"Vous êtes au milieu d'une manche !\n"CRESET);
+                send_msg(p,MSG_IN_ROUND,NULL);
             }
             break;
         case CARD:
-            if(g->state == PLAY_STATE && ctoint(cmd) != -1){
+            if(g->state == PLAY_STATE && g->countdown_step >= 0){
+                send_msg(p,MSG_COUNTDOWN_RUNNING,NULL);
+            } else if(g->state == PLAY_STATE && ctoint(cmd) != -1){
                 int card = ctoint(cmd);
                 if(play_card(g,p,card) == NO_CARD)
-                    send_p(p,RED"Vous n'avez pas la carte %d\n"CRESET,card);
+                    send_msg(p,MSG_NO_CARD,MSG_ARGS(ARG_D(card)));
             }
             break;
         case STOP:
             if(g->state == GAME_STATE) {
                 end_game(g,p,false);
             } else if (g->state == PLAY_STATE){
-                send_p(p,RED"Une manche est en cours !\n"CRESET);
+                send_msg(p,MSG_ROUND_RUNNING,NULL);
             }
             break;
         case ROBOT_ADD:
@@ -107,54 +175,200 @@ void handle_command(const char* cmd, Game *g, Player *p){
                 if(g->playerList->count < g->playerList->max){
                     char name[50];
                     snprintf(name, sizeof(name),"Robot%d",g->playerList->count);
-                    start_robot(name);
+                    start_robot(name,g->id);
                 } else {
-                    send_p(p,RED"Le lobby est déja plein !\n"CRESET);
+                    send_msg(p,MSG_LOBBY_FULL,NULL);
                 }
             } else {
-                send_p(p,RED"Vous ne pouvez ajouter un robot uniquement dans le lobby\n"CRESET);
+                send_msg(p,MSG_ROBOT_LOBBY_ONLY,NULL);
+            }
+            break;
+        case MEMSTATS:
+            if(p->admin){
+                char report[BUFSIZ];
+                mem_report(report,sizeof(report));
+                send_p(p,"%s",report);
+            } else {
+                send_msg(p,MSG_ADMIN_ONLY,NULL);
+            }
+            break;
+        case COLOR:
+            p->style = MSG_COLOR;
+            send_msg(p,MSG_COLOR_ON,NULL);
+            break;
+        case NO_COLOR:
+            p->style = MSG_PLAIN;
+            send_msg(p,MSG_COLOR_OFF,NULL);
+            break;
+        case DELTA:
+            p->delta = true;
+            send_msg(p,MSG_DELTA_ON,NULL);
+            break;
+        case NO_DELTA:
+            p->delta = false;
+            send_msg(p,MSG_DELTA_OFF,NULL);
+            break;
+        case STATE:
+            send_state(g,p);
+            break;
+        case ANALYTICS:
+            if(p->admin){
+                char report[BUFSIZ];
+                send_raw(p,report,analytics_report(report,sizeof(report)));
+            } else {
+                send_msg(p,MSG_ADMIN_ONLY,NULL);
             }
             break;
+        case PROFILE:
+            print_profile(p,cmd[7] == ' ' && cmd[8] != '\0' ? cmd + 8 : NULL); // "profile" or "profile <name>"
+            break;
         default:
             printf("%s a envoyé : %s\n",p->name,cmd);
     }
+    TRACE_END_ROOM(span,command_span(code),g->id);
+}
+/**
+ * @brief Handles a message of a table, called by its executor thread.
+ *
+ * Players join and leave the table, and their commands are applied, only from here.
+ *
+ * @param g Table of the message.
+ * @param msg Message posted by a client thread.
+ */
+void handle_room_msg(Game *g, RoomMsg *msg){
+    Player *p = msg->p;
+    switch (msg->type) {
+        case ROOM_JOIN:
+            p = accept_seat(matchmaker,g,msg->fd,msg->cmd);
+            msg->reply->player = p;
+            if(p != NULL){
+                p->admin = msg->admin;
+                send_msg(p,MSG_SEATED,MSG_ARGS(ARG_D(g->id)));
+                send_msg(p,MSG_SESSION,MSG_ARGS(ARG_S(p->token)));
+                broadcast_game(g,NULL,B_CONSOLE,MSG_JOINED,MSG_ARGS(ARG_S(p->name)));
+                request_state_render(g); // Lobby sent once for a burst of joins
+            }
+            sem_post(&msg->reply->done);
+            break;
+        case ROOM_COMMAND:
+            handle_command(msg->cmd,g,p);
+            break;
+        case ROOM_RESUME:
+            msg->reply->player = keepalive ? resume_player(g,msg->fd,msg->cmd) : NULL;
+            sem_post(&msg->reply->done);
+            break;
+        case ROOM_SHUTDOWN:
+            broadcast_game(g,NULL,B_CONSOLE,MSG_SHUTDOWN,NULL);
+            disconnect_allP(g->playerList); // Client threads post their ROOM_DROP and end.
+            break;
+        case ROOM_DROP:
+        case ROOM_LEAVE:
+            if(msg->fd >= 0 && msg->fd != p->socket_fd){
+                close(msg->fd); // Old connection, the seat was resumed by a new one
+                break;
+            }
+            if(msg->type == ROOM_DROP && g->state != LOBBY_STATE){
+                hold_player(g,p); // The game goes on, the player may come back with its token
+                break;
+            }
+            // Cleanup player. @warning the order is important here.
+            close_player_socket(p);
+            broadcast_game(g,p,B_CONSOLE,MSG_LEFT,MSG_ARGS(ARG_S(p->name)));
+
+            // End game if needed.
+            if(g->state == GAME_STATE ) {
+                end_game(g,p,true);
+            }
+            if(g->state == PLAY_STATE){
+                end_round(g,0);
+                end_game(g,p,true);
+            }
+
+            leave_table(matchmaker,g,p);
+            request_state_render(g);
+            break;
+        default:
+            break;
+    }
+    update_seats(matchmaker,g); // Seats opened or closed by the message
 }
 /**
  * @brief Handles a client connection in a separate thread.
  *
- * This function manages the communication with a single client, including
- * initializing the player, handling commands, broadcasting messages to other
- * players, and cleaning up when the client disconnects.
+ * This function reads the name of the client and waits for a seat, or takes back a held seat
+ * with a session token. It then posts the commands of the player to the executor of its table
+ * until the client quits or its connection is lost.
  *
  * @param arg A pointer to a `ClientThreadArgs` structure.
  * @return Always returns `NULL` when the client thread ends.
- * @note This function frees the memory allocated for the `ClientThreadArgs` structure.
+ * @note This function gives the `ClientThreadArgs` slot back to the pool.
  * @warning This function must be called in a separate thread for each client.
  */
+/**
+ * @brief Wait for the first line of a client, the wait ends with the server.
+ * @return true if the line can be read.
+ */
+static bool wait_handshake(int fd){
+    struct pollfd pfd = {.fd = fd, .events = POLLIN};
+    while(keepalive){
+        int r = poll(&pfd,1,HANDSHAKE_POLL_MS);
+        if(r > 0) return true;
+        if(r == -1 && errno != EINTR) return false;
+    }
+    return false;
+}
 void *handle_client(void *arg) {
     // Extracted variable from arg.
     ClientThreadArgs *args = (ClientThreadArgs *)arg;
-    Player *p = args->p;
-    Game *game = args->game;
-    PlayerList *pl = game->playerList;
-    free(args);
+    int client_fd = args->socket_fd;
+    int admin = args->admin;
+    Matchmaker *mm = args->mm;
+    release_conn(args);
 
-    char name[50] = {0}; // Buffer for player's name.
+    char name[64] = {0}; // Buffer for player's name and table option.
 
     // First welcome message, ask for the name.
-    send_p(p,"Bienvenue sur TheMind ! \nEnvoyé votre nom\n");
+    msg_send(client_fd,MSG_WELCOME,NULL);
 
-    recv(p->socket_fd,name,sizeof (name) -1, 0);
-    set_player_name(pl,p,name);
+    if(!wait_handshake(client_fd) || recv(client_fd,name,sizeof (name) -1, 0) <= 0){
+        close(client_fd);
+        atomic_fetch_sub(&nb_clients,1);
+        return NULL;
+    }
+    Game *game;
+    Player *p;
+    if(strncmp(name,"resume ",7) == 0){
+        // Back after a lost connection : "resume <token>", the token starts with the table id.
+        char *token = name + 7;
+        token[strcspn(token,"\r\n")] = '\0';
+        game = get_table(mm,atoi(token));
+        p = game != NULL ? resume_session(game,client_fd,token) : NULL;
+        if(p == NULL){
+            msg_send(client_fd,MSG_RESUME_FAILED,NULL);
+            close(client_fd);
+            atomic_fetch_sub(&nb_clients,1);
+            return NULL;
+        }
+    } else {
+        int size, table_id;
+        if(parse_handshake(name,&size,&table_id) == -1){
+            msg_send(client_fd,MSG_BAD_HANDSHAKE,NULL);
+            size = 0;
+            table_id = -1;
+        }
 
-    broadcast_message(pl,NULL,B_CONSOLE,GRN"\n%s a rejoint !\n\n"CRESET,p->name);
-    print_lobbyState(game); // Send lobby message broadcast
+        // Wait for a seat, the executor of the table creates the player.
+        if(join_table(mm,client_fd,name,size,table_id,admin,&game,&p) != MATCH_SEATED){
+            atomic_fetch_sub(&nb_clients,1);
+            return NULL;
+        }
+    }
 
-    // Loop on client commands
+    // Loop on client commands, handled by the executor of the table.
     char buffer[BUFSIZ];
+    bool quit = false;
     while(1){
-        memset(buffer,0,sizeof(buffer));
-        ssize_t len = recv(p->socket_fd,buffer,sizeof (buffer) -1, 0);
+        ssize_t len = recv(client_fd,buffer,sizeof (buffer) -1, 0);
         if (len <= 0) break;
 
         // Ensure that the commands end with \0. If chains contains \n replace this by \0.
@@ -162,25 +376,16 @@ void *handle_client(void *arg) {
         char* end = strchr(buffer, '\n');
         if (end) *end = '\0';
 
-        // Call the command handler
-        handle_command(buffer,game,p);
-    }
-
-    // Cleanup player. @warning the order is important here.
-    close(p->socket_fd);
-    broadcast_message(pl,p,B_CONSOLE,GRN"\n%s a quitté!\n\n"CRESET,p->name);
-
-    // End game if needed.
-    if(game->state == GAME_STATE ) {
-        end_game(game,p,true);
-    }
-    if(game->state == PLAY_STATE){
-        end_round(game,0);
-        end_game(game,p,true);
+        if (hash_cmd(buffer) == QUIT) {
+            quit = true;
+            break;
+        }
+        post_room(game,ROOM_COMMAND,p,buffer);
     }
 
-    remove_player(pl,p);
-    print_lobbyState(game);
+    // The executor closes the socket and frees the player or holds its seat, p must not be used after this.
+    post_disconnect(game,quit ? ROOM_LEAVE : ROOM_DROP,p,client_fd);
+    atomic_fetch_sub(&nb_clients,1);
     return NULL;
 }
 /**
@@ -192,74 +397,51 @@ void *handle_client(void *arg) {
  * @param LTargs A pointer to a `ListentThreadArgs` structure.
  * @return NULL This function does not return a value. It runs in an infinite loop
  *         until the `keepalive` condition is no longer true.
- * @note The function dynamically allocates memory for `ClientThreadArgs`
- *       for each accepted client. This memory is freed after the client thread is created.
+ * @note The `ClientThreadArgs` of each accepted client are taken from a preallocated pool,
+ *       the client thread gives its slot back once started.
  */
 void *handle_new_connection(void *LTargs){
     ListentThreadArgs *arg_in = (ListentThreadArgs *)LTargs;
 
-    Game *game = arg_in->game;
+    Matchmaker *mm = arg_in->mm;
     int listen_fd = arg_in->listen_fd;
 
-    free(LTargs);
+    mem_free(MEM_NETWORK,LTargs);
 
     while(keepalive){
         struct sockaddr_in client_addr;
         socklen_t client_len = sizeof(client_addr);
 
-        ClientThreadArgs *CTargs = malloc(sizeof(ClientThreadArgs));
-        if(CTargs == NULL) {
-            free(CTargs);
-            perror("ERROR allocation memory for thread args\n");
-            continue;
-        }
-
         int client_fd = accept(listen_fd, (struct sockaddr*)&client_addr, &client_len);
         if(client_fd < 0){
             if (errno == EBADF || errno == EINTR) { // EBADF : socket fermée
-                free(CTargs);
                 printf("[AC] Socket fermée, arrêt du thread.\n");
                 break;
             } else {
-                free(CTargs);
                 perror("ERROR accepting connection");
                 continue;
             }
         }
-
-
-        if(!is_full(game->playerList)){
-            send(client_fd,SERVER_FULL_MSG, strlen(SERVER_FULL_MSG),0);
-            close(client_fd);
-            free(CTargs);
-            printf("A client tried to connect, but the server is full.\n");
-            continue;
-        }
-
-        if(game->state == GAME_STATE || game->state == PLAY_STATE){
-            send(client_fd,GAME_STARTED_MSG, strlen(GAME_STARTED_MSG),0);
+        ClientThreadArgs *CTargs = acquire_conn();
+        if(CTargs == NULL) {
+            msg_send(client_fd,MSG_SERVER_FULL,NULL);
             close(client_fd);
-            free(CTargs);
-            printf("A client tried to connect, but the game is started.\n");
             continue;
         }
+        int nodelay = 1; // The output is already coalesced once per tick
+        setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
 
-        CTargs->game = game;
-        CTargs->p = create_player(game->playerList,client_fd);
-        if(CTargs->p == NULL){
-            send(client_fd,SERVER_FULL_MSG, strlen(SERVER_FULL_MSG),0);
-            close(client_fd);
-            free(CTargs);
-            printf("A client tried to connect, but the server is full.\n");
-            continue;
-        }
+        CTargs->socket_fd = client_fd;
+        CTargs->admin = ntohl(client_addr.sin_addr.s_addr) >> 24 == 127; // Loopback only
+        CTargs->mm = mm;
 
         pthread_t thread_id;
+        atomic_fetch_add(&nb_clients,1);
         if (pthread_create(&thread_id,NULL,handle_client,CTargs) != 0){
+            atomic_fetch_sub(&nb_clients,1);
             perror("ERROR creating thread\n");
-            remove_player(CTargs->game->playerList,CTargs->p); // Think to remove player from the pl
             close(client_fd);
-            free(CTargs);
+            release_conn(CTargs);
             continue;
         }
 
@@ -267,23 +449,84 @@ void *handle_new_connection(void *LTargs){
     }
     return NULL;
 }
+/**
+ * @brief Check that a requested file stays in PDF_DIR.
+ */
+static bool valid_filename(const char *filename){
+    return filename[0] != '\0' && filename[0] != '.' && strchr(filename,'/') == NULL;
+}
+/**
+ * @brief FNV-1a hash of a file, read from its current position.
+ */
+static uint64_t hash_file(FILE *file){
+    uint64_t hash = 14695981039346656037ULL;
+    unsigned char buf[4096];
+    size_t n;
+    while ((n = fread(buf,1,sizeof(buf),file)) > 0) {
+        for (size_t i = 0; i < n; ++i) {
+            hash = (hash ^ buf[i]) * 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+/**
+ * @brief Answer "stat name" : "size hash" of the file, so that the client can skip or resume a download.
+ */
+static void send_file_stat(int client_fd, const char *filepath){
+    FILE *file = fopen(filepath,"rb");
+    if (file == NULL) {
+        write(client_fd,DL_NOT_FOUND,strlen(DL_NOT_FOUND));
+        return;
+    }
+    struct stat st;
+    fstat(fileno(file),&st);
+    char reply[64];
+    int len = snprintf(reply,sizeof(reply),"%lld %016llx\n",(long long)st.st_size,(unsigned long long)hash_file(file));
+    fclose(file);
+    write(client_fd,reply,len);
+}
+/**
+ * @brief Answer "getfile name [offset]" : the content of the file from offset.
+ */
+static void send_file(int client_fd, const char *filepath, long offset){
+    FILE *file = fopen(filepath,"rb");
+    if (file == NULL) {
+        write(client_fd,DL_NOT_FOUND,strlen(DL_NOT_FOUND));
+        return;
+    }
+    if (offset > 0 && fseek(file,offset,SEEK_SET) != 0) {
+        fclose(file);
+        return;
+    }
+    char file_buf[BUFSIZ];
+    size_t bytes_read;
+    while ((bytes_read = fread(file_buf,1, sizeof(file_buf),file)) > 0 ){
+        if (send(client_fd,file_buf,bytes_read,MSG_NOSIGNAL) != (ssize_t)bytes_read) break; // Client gone, it can resume
+    }
+    fclose(file);
+    printf("[DL] Fichier %s envoyé à partir de l'octet %ld\n",filepath,offset);
+}
 /**
  * @brief Handle requests for pdf stats file download
+ *
+ * Requests, one per connection : "getfile name [offset]" sends the file from offset,
+ * "stat name" sends its size and hash.
+ *
  * @param args Pointer to the listening socket
  * @return NULL This function does not return a value. It runs in an infinite loop
  *         until the `keepalive` condition is no longer true.
  */
 void *handle_downloads(void *args){
     int dl_fd = *(int*)args;
-    free(args);
+    mem_free(MEM_NETWORK,args);
 
     printf("[DL] Server ready to handle new downloading request\n");
     while(keepalive){
         struct sockaddr_in client_addr;
         socklen_t addr_len = sizeof(client_addr);
         int client_fd = accept(dl_fd, (struct sockaddr *)&client_addr, &addr_len);
-        if(dl_fd < 0) {
-            if (errno == EBADF || errno == EINTR) { // EBADF : socket fermée
+        if(client_fd < 0) {
+            if (errno == EBADF || errno == EINVAL || errno == EINTR) { // EBADF : socket fermée
                 printf("[DL] Socket fermée, arrêt du thread.\n");
                 break;
             } else {
@@ -299,28 +542,24 @@ void *handle_downloads(void *args){
             close(client_fd);
             continue;
         }
+        buffer[strcspn(buffer,"\r\n")] = '\0';
         printf("[DL] Requête reçue : %s\n",buffer);
 
-        // send file if valide request
-        if(strncmp(buffer, "getfile",7) == 0){
-            char *filename = buffer + 8;
-            filename[strcspn(filename,"\n")] = '\0';
+        char command[16], filename[200];
+        long offset = 0;
+        int nb_fields = sscanf(buffer,"%15s %199s %ld",command,filename,&offset);
+        if(nb_fields < 2 || offset < 0 || !valid_filename(filename)){
+            write(client_fd,DL_INVALID,strlen(DL_INVALID));
+        } else {
             char filepath[256];
             snprintf(filepath,sizeof(filepath),PDF_DIR"/%s",filename);
-            FILE *file = fopen(filepath,"rb");
-            if (file){
-                char file_buf[1024];
-                size_t bytes_read;
-                while ((bytes_read = fread(file_buf,1, sizeof(file_buf),file)) > 0 ){
-                    send(client_fd,file_buf,bytes_read,0);
-                }
-                fclose(file);
-                printf("[DL] Fichier %s envoyé avec succès\n",filename);
+            if(strcmp(command,"getfile") == 0){
+                send_file(client_fd,filepath,offset);
+            } else if(strcmp(command,"stat") == 0){
+                send_file_stat(client_fd,filepath);
             } else {
-                write(client_fd,"Erreur : fichier non trouvé\n",28);
+                write(client_fd,DL_INVALID,strlen(DL_INVALID));
             }
-        } else {
-            write(client_fd,"Commande invalide\n",19);
         }
         close(client_fd);
     }
@@ -334,7 +573,6 @@ void *handle_downloads(void *args){
  */
 void handle_sigint(int sig) {
     keepalive = 0;
-    pthread_cond_signal(&keepalive_cond);  // Signale au th
 }
 /**
  * @brief Creates and binds a listening socket for the server.
@@ -390,31 +628,43 @@ int main(int argc, char* argv[]) {
         exit(EXIT_FAILURE);
     }
     signal(SIGINT,handle_sigint); // Catch signal SIGINT (CTRL +C).
+    signal(SIGTERM,handle_sigint); // docker stop. SIGINT is ignored while system() runs a stats script.
+    signal(SIGPIPE,SIG_IGN); // A client leaving must not kill the server, send() reports EPIPE.
 
-    pthread_mutex_init(&keepalive_mutex,NULL); //Init mutex keepalive for stopping serveur.
-    pthread_cond_init(&keepalive_cond,NULL); //Init condition.
+    // SIGINT and SIGTERM are blocked in every thread, the main thread only takes them in sigsuspend.
+    sigset_t sigint_set, wait_set;
+    sigemptyset(&sigint_set);
+    sigaddset(&sigint_set,SIGINT);
+    sigaddset(&sigint_set,SIGTERM);
+    pthread_sigmask(SIG_BLOCK,&sigint_set,&wait_set);
 
     srand(time(NULL)); // Init random seed.
+    trace_init(); // Enabled by the THEMIND_TRACE environment variable.
+    profiles_open(PROFILE_FILE); // Kept in memory only if the file can't be used.
 
     int port = atoi(argv[1]); // Listening port.
     s_port = port;
     int backlog = atoi(argv[2]); // Max connection on waiting queue.
     int listen_fd = create_listening_socket(port,backlog); // Listening socket to handle connection
 
-    PlayerList *pl = init_pl(MAX_PLAYERS); // Create the player list
-    Game *g = create_game(pl); // Create the game management system.
+    Matchmaker *mm = create_matchmaker(handle_room_msg); // Tables and waiting queue, tables are opened on demand.
+    matchmaker = mm;
+    if(mm == NULL){
+        perror("ERROR creating matchmaker");
+        exit(EXIT_FAILURE);
+    }
 
     /**
      * Listening Thread.
      */
-    ListentThreadArgs *LTargs = malloc(sizeof(ListentThreadArgs)); // Listening Thread args
-    LTargs->game = g;
+    ListentThreadArgs *LTargs = mem_malloc(MEM_NETWORK,sizeof(ListentThreadArgs)); // Listening Thread args
+    LTargs->mm = mm;
     LTargs->listen_fd = listen_fd;
 
     pthread_t tid;
     if (pthread_create(&tid,NULL,handle_new_connection,LTargs) != 0){ // Create listening thread
         perror("ERROR creating thread\n");
-        free(LTargs);
+        mem_free(MEM_NETWORK,LTargs);
         exit(EXIT_FAILURE);
     }
 
@@ -423,21 +673,20 @@ int main(int argc, char* argv[]) {
      */
     int port2 = atoi(argv[1]) + 1;
     int download_fd = create_listening_socket(port2,backlog);
-    int *dl_arg = malloc(sizeof(int));
+    int *dl_arg = mem_malloc(MEM_NETWORK,sizeof(int));
     *dl_arg = download_fd;
 
     pthread_t tid_dl;
     if(pthread_create(&tid_dl,NULL,handle_downloads,dl_arg) != 0){
         perror("ERROR creating downloading handler thread\n");
-        free(dl_arg);
+        mem_free(MEM_NETWORK,dl_arg);
         exit(EXIT_FAILURE);
     }
 
-    pthread_cond_wait(&keepalive_cond, &keepalive_mutex);  // wait for the sigint signal
+    while(keepalive) sigsuspend(&wait_set);  // wait for the sigint signal
 
     /* Shutdown server and free ressources*/
-    broadcast_message(pl,NULL,B_CONSOLE,RED"\nLe serveur va se fermer, vous allez être déconnecté.\n\n"CRESET);
-    disconnect_allP(pl); // Close all clients socket.
+    stop_matchmaker(mm); // Waiting clients leave, the executors disconnect their players.
 
     shutdown(listen_fd,SHUT_RDWR);
     close(listen_fd); // Close listening socket.
@@ -447,8 +696,19 @@ int main(int argc, char* argv[]) {
     pthread_join(tid,NULL);
     pthread_join(tid_dl,NULL);
 
-    free_player_list(pl);
-    free_game(g);
+    // The executors handle ROOM_SHUTDOWN before stopping, the messages posted later are never handled.
+    stop_tables(mm);
+    // Client threads end once disconnected, the tables are freed after their last post.
+    while(atomic_load(&nb_clients) > 0) {
+        usleep(10000);
+    }
+    free_matchmaker(mm);
+    profiles_close();
+    trace_flush();
+
+    char report[BUFSIZ];
+    mem_report(report,sizeof(report));
+    printf("%s",report);
 
     printf("Serveur fermé\n");
     return 0;
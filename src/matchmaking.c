@@ -0,0 +1,410 @@
+//
+// Created by erwan on 19/10/2026.
+//
+
+#include <errno.h>
+#include <ctype.h>
+#include <sys/random.h>
+#include "matchmaking.h"
+
+/**
+ * @brief Create the matchmaker, without any table.
+ * @param handler Handler of the executor started for every table.
+ */
+Matchmaker *create_matchmaker(room_handler handler) {
+    Matchmaker *mm = mem_malloc(MEM_GAME, sizeof(Matchmaker));
+    if (mm == NULL) return NULL;
+    mm->handler = handler;
+    mm->nb_tables = 0;
+    mm->nb_waiting = 0;
+    mm->running = true;
+    pthread_mutex_init(&mm->mutex, NULL);
+    pthread_cond_init(&mm->cond, NULL);
+    return mm;
+}
+
+/**
+ * @brief Stop and join the executor of every table, the pending replies are answered.
+ * @note Called after stop_matchmaker : no table is opened anymore.
+ */
+void stop_tables(Matchmaker *mm) {
+    for (int i = 0; i < mm->nb_tables; ++i) {
+        stop_executor(mm->tables[i]);
+    }
+}
+
+/**
+ * @brief Stop the executors if still running, then free every table and its players.
+ * @warning The client threads must not use the tables anymore.
+ */
+void free_matchmaker(Matchmaker *mm) {
+    if (mm == NULL) return;
+    stop_tables(mm);
+    for (int i = 0; i < mm->nb_tables; ++i) {
+        PlayerList *pl = mm->tables[i]->playerList;
+        free_game(mm->tables[i]);
+        free_player_list(pl);
+    }
+    pthread_mutex_destroy(&mm->mutex);
+    pthread_cond_destroy(&mm->cond);
+    mem_free(MEM_GAME, mm);
+}
+
+/**
+ * @brief Wake the waiting players so that they leave, their connection is closed.
+ *
+ * Every executor is asked to disconnect the players of its table with ROOM_SHUTDOWN, no table is opened anymore.
+ */
+void stop_matchmaker(Matchmaker *mm) {
+    pthread_mutex_lock(&mm->mutex);
+    mm->running = false;
+    for (int i = 0; i < mm->nb_tables; ++i) {
+        post_room(mm->tables[i], ROOM_SHUTDOWN, NULL, NULL);
+    }
+    pthread_cond_broadcast(&mm->cond);
+    pthread_mutex_unlock(&mm->mutex);
+}
+
+/**
+ * @brief Split the first line of a client : "name [size]" or "name @table".
+ *
+ * The option is removed from the line, which only keeps the name.
+ *
+ * @param line First line sent by the client, modified.
+ * @param size Wanted table size (1 to MAX_PLAYERS), 0 if not given.
+ * @param table_id Wanted table, -1 if not given.
+ * @return 0, or -1 if the option is invalid.
+ */
+int parse_handshake(char *line, int *size, int *table_id) {
+    *size = 0;
+    *table_id = -1;
+    line[strcspn(line, "\r\n")] = '\0';
+
+    char *option = strrchr(line, ' ');
+    if (option == NULL) return 0;
+    char *value = option + 1;
+    bool is_table = value[0] == '@';
+    if (is_table) value++;
+    if (value[0] == '\0') return -1;
+    for (char *c = value; *c; ++c) {
+        if (!isdigit((unsigned char)*c)) return 0; // Part of the name
+    }
+    int n = atoi(value);
+    if (is_table) {
+        *table_id = n;
+    } else if (n >= 1 && n <= MAX_PLAYERS) {
+        *size = n;
+    } else {
+        return -1;
+    }
+    *option = '\0';
+    return 0;
+}
+
+static int seats_of(Game *g) {
+    return g->size > 0 ? g->size : g->playerList->max;
+}
+
+/**
+ * @brief Players of a lobby table, counting the seats given but not yet taken.
+ * @return The count, or -1 if the table is playing.
+ * @note Called with the matchmaker mutex held : the executor publishes its count under it.
+ */
+static int lobby_count(Game *g) {
+    int count = atomic_load(&g->lobby_players);
+    return count < 0 ? -1 : count + g->reserved;
+}
+
+static bool is_open(Game *g) {
+    int count = lobby_count(g);
+    return count >= 0 && count < seats_of(g);
+}
+
+/**
+ * @brief Open table for a waiting player, the fullest one first.
+ * @param size Wanted size, 0 for any.
+ * @param relaxed true if any table size is accepted.
+ */
+static Game *find_open_table(Matchmaker *mm, int size, bool relaxed) {
+    Game *best = NULL;
+    for (int i = 0; i < mm->nb_tables; ++i) {
+        Game *g = mm->tables[i];
+        if (!is_open(g) || lobby_count(g) == 0) continue;
+        if (!relaxed && g->size != size) continue;
+        if (best == NULL || lobby_count(g) > lobby_count(best)) best = g;
+    }
+    return best;
+}
+
+/**
+ * @brief Reuse an empty lobby table, or create a new one.
+ * @return The table, or NULL if MAX_TABLES are in use.
+ */
+static Game *open_table(Matchmaker *mm, int size) {
+    for (int i = 0; i < mm->nb_tables; ++i) {
+        Game *g = mm->tables[i];
+        if (lobby_count(g) == 0) {
+            g->size = size;
+            return g;
+        }
+    }
+    if (mm->nb_tables == MAX_TABLES) return NULL;
+
+    PlayerList *pl = init_pl(MAX_PLAYERS);
+    if (pl == NULL) return NULL;
+    Game *g = create_game(pl);
+    if (g == NULL) {
+        free_player_list(pl);
+        return NULL;
+    }
+    if (start_executor(g, mm->handler) == -1) {
+        free_game(g);
+        free_player_list(pl);
+        return NULL;
+    }
+    g->size = size;
+    mm->tables[mm->nb_tables++] = g;
+    printf("Table %d ouverte (%d places)\n", g->id, seats_of(g));
+    return g;
+}
+
+static Game *find_table(Matchmaker *mm, int table_id) {
+    for (int i = 0; i < mm->nb_tables; ++i) {
+        if (mm->tables[i]->id == table_id) return mm->tables[i];
+    }
+    return NULL;
+}
+
+/**
+ * @brief Get a table by its id.
+ * @return The table, or NULL if it doesn't exist. Tables live as long as the matchmaker.
+ */
+Game *get_table(Matchmaker *mm, int table_id) {
+    pthread_mutex_lock(&mm->mutex);
+    Game *g = find_table(mm, table_id);
+    pthread_mutex_unlock(&mm->mutex);
+    return g;
+}
+
+/**
+ * @brief Session token of a new player : "table-random", the table is found from the token on resume.
+ */
+static void new_token(char *token, size_t size, int table_id) {
+    unsigned long long r;
+    if (getrandom(&r, sizeof(r), 0) != sizeof(r)) {
+        r = ((unsigned long long)rand() << 32) ^ (unsigned long long)rand() ^ (unsigned long long)time(NULL);
+    }
+    snprintf(token, size, "%d-%016llx", table_id, r);
+}
+
+/**
+ * @brief Give the waiting players the seats that can be, in arrival order.
+ *
+ * A seat is only reserved : the player is created by the executor of the table, see accept_seat.
+ *
+ * @note Called with the matchmaker mutex held.
+ */
+static void schedule_seats(Matchmaker *mm) {
+    if (!mm->running) return;
+    TRACE_BEGIN(span);
+    time_t now = time(NULL);
+    bool seated = false;
+
+    for (int i = 0; i < mm->nb_waiting; ++i) {
+        WaitingPlayer *w = mm->queue[i];
+        bool relaxed = w->size == 0 || now - w->since >= MATCH_RELAX_DELAY;
+        Game *g = find_open_table(mm, w->size, relaxed);
+        if (g == NULL) {
+            // A new table of the wanted size needs enough players waiting for it.
+            int same_size = 0;
+            for (int j = i; j < mm->nb_waiting; ++j) {
+                if (mm->queue[j]->size == w->size) same_size++;
+            }
+            if (relaxed || same_size >= w->size) g = open_table(mm, w->size);
+        }
+        if (g == NULL) continue;
+        g->reserved++;
+        w->table = g;
+        seated = true;
+    }
+
+    if (seated) {
+        int kept = 0;
+        for (int i = 0; i < mm->nb_waiting; ++i) {
+            if (mm->queue[i]->table == NULL) mm->queue[kept++] = mm->queue[i];
+        }
+        mm->nb_waiting = kept;
+        pthread_cond_broadcast(&mm->cond);
+    }
+    TRACE_END(span, "match:schedule");
+}
+
+static void remove_waiting(Matchmaker *mm, WaitingPlayer *w) {
+    for (int i = 0; i < mm->nb_waiting; ++i) {
+        if (mm->queue[i] == w) {
+            memmove(&mm->queue[i], &mm->queue[i + 1], (mm->nb_waiting - i - 1) * sizeof(WaitingPlayer *));
+            mm->nb_waiting--;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Publish the lobby count of a table, and give its free seats to the waiting players.
+ *
+ * Called by the executor of the table after every message, the matchmaker never reads the game state itself.
+ */
+void update_seats(Matchmaker *mm, Game *g) {
+    int count = g->state == LOBBY_STATE ? g->playerList->count : -1;
+    if (atomic_load(&g->lobby_players) == count) return;
+    pthread_mutex_lock(&mm->mutex);
+    atomic_store(&g->lobby_players, count);
+    schedule_seats(mm);
+    pthread_mutex_unlock(&mm->mutex);
+}
+
+/**
+ * @brief Take a seat given by the matchmaker, called by the executor of the table on ROOM_JOIN.
+ *
+ * The seat is refused if the table left the lobby or is full since it was given, or if the server stops.
+ *
+ * @param socket_fd Socket of the client, owned by the player on success.
+ * @return The player, or NULL if the seat is refused.
+ */
+Player *accept_seat(Matchmaker *mm, Game *g, int socket_fd, const char *name) {
+    Player *p = NULL;
+    pthread_mutex_lock(&mm->mutex);
+    if (g->reserved > 0) g->reserved--;
+    if (mm->running && g->state == LOBBY_STATE && g->playerList->count < seats_of(g)) {
+        p = create_player(g->playerList, socket_fd);
+    }
+    if (p != NULL) {
+        char buffer[50];
+        snprintf(buffer, sizeof(buffer), "%s", name);
+        set_player_name(g->playerList, p, buffer);
+        new_token(p->token, sizeof(p->token), g->id);
+    }
+    atomic_store(&g->lobby_players, g->state == LOBBY_STATE ? g->playerList->count : -1);
+    if (p == NULL) schedule_seats(mm); // The seat given back may suit another waiting player
+    pthread_mutex_unlock(&mm->mutex);
+    return p;
+}
+
+/**
+ * @brief Wait in the queue until a seat is given to the player.
+ * @param notified The player was already told it waits.
+ * @return true if w->table holds the given seat, false if the queue is full, the player left or the server stops.
+ * @note Called with the matchmaker mutex held.
+ */
+static bool wait_seat(Matchmaker *mm, WaitingPlayer *w, bool notified) {
+    if (mm->nb_waiting == MAX_WAITING) {
+        msg_send(w->socket_fd, MSG_SERVER_FULL, NULL);
+        return false;
+    }
+    mm->queue[mm->nb_waiting++] = w;
+    schedule_seats(mm);
+
+    if (w->table == NULL && !notified) {
+        msg_send(w->socket_fd, MSG_WAITING, MSG_ARGS(ARG_D(mm->nb_waiting)));
+    }
+    while (w->table == NULL && mm->running) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += MATCH_POLL_MS / 1000;
+        deadline.tv_nsec += (MATCH_POLL_MS % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        if (pthread_cond_timedwait(&mm->cond, &mm->mutex, &deadline) == ETIMEDOUT) {
+            char c;
+            ssize_t r = recv(w->socket_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+            if (r == 0 || (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) break; // Left while waiting
+            schedule_seats(mm); // Delays of the waiting players
+        }
+    }
+    if (w->table == NULL) {
+        remove_waiting(mm, w);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Join the table asked with "@table" : seated if it is in the lobby with a free seat, spectator otherwise.
+ */
+static int join_given_table(Matchmaker *mm, int socket_fd, const char *name, int table_id, int admin, Game **game, Player **player) {
+    pthread_mutex_lock(&mm->mutex);
+    Game *g = find_table(mm, table_id);
+    bool reserved = g != NULL && is_open(g);
+    if (reserved) g->reserved++;
+    pthread_mutex_unlock(&mm->mutex);
+    if (g == NULL) {
+        msg_send(socket_fd, MSG_UNKNOWN_TABLE, NULL);
+        close(socket_fd);
+        return MATCH_REFUSED;
+    }
+    if (reserved) {
+        *player = request_seat(g, socket_fd, name, admin);
+        if (*player != NULL) {
+            *game = g;
+            return MATCH_SEATED;
+        }
+    }
+    msg_send(socket_fd, MSG_SPECTATOR, NULL);
+    if (g->spectators == NULL || add_spectator(g->spectators, socket_fd) == -1) {
+        msg_send(socket_fd, MSG_TABLE_BUSY, NULL);
+        close(socket_fd);
+        return MATCH_REFUSED;
+    }
+    return MATCH_SPECTATOR;
+}
+
+/**
+ * @brief Seat a new connection, waiting in the queue if needed.
+ *
+ * The calling thread blocks until the player is seated, leaves, or the server stops. A seat refused
+ * by the executor of its table puts the player back in the queue, with its arrival time.
+ *
+ * @param socket_fd Socket of the client.
+ * @param name Name of the player.
+ * @param size Wanted table size, 0 for any.
+ * @param table_id Table asked by the client, -1 to let the matchmaker choose.
+ * @param admin The connection comes from the server host.
+ * @param game Table of the player, when seated.
+ * @param player Player created in the table, when seated.
+ * @return MATCH_SEATED, MATCH_SPECTATOR (the socket is owned by the spectators of the table)
+ *         or MATCH_REFUSED (the socket is closed).
+ */
+int join_table(Matchmaker *mm, int socket_fd, const char *name, int size, int table_id, int admin, Game **game, Player **player) {
+    if (table_id >= 0) return join_given_table(mm, socket_fd, name, table_id, admin, game, player);
+
+    WaitingPlayer w = {.socket_fd = socket_fd, .size = size, .since = time(NULL), .table = NULL, .player = NULL};
+    snprintf(w.name, sizeof(w.name), "%s", name);
+    bool notified = false;
+    while (1) {
+        pthread_mutex_lock(&mm->mutex);
+        if (!wait_seat(mm, &w, notified)) {
+            pthread_mutex_unlock(&mm->mutex);
+            close(socket_fd);
+            return MATCH_REFUSED;
+        }
+        pthread_mutex_unlock(&mm->mutex);
+        notified = true;
+
+        w.player = request_seat(w.table, socket_fd, w.name, admin);
+        if (w.player != NULL) break;
+        w.table = NULL; // Refused by the executor : back in the queue
+    }
+
+    *game = w.table;
+    *player = w.player;
+    return MATCH_SEATED;
+}
+/**
+ * @brief Remove a player from its table and give the free seat to the waiting players.
+ */
+void leave_table(Matchmaker *mm, Game *g, Player *p) {
+    remove_player(g->playerList, p);
+    update_seats(mm, g);
+}
@@ -0,0 +1,69 @@
+//
+// Created by erwan on 19/10/2026.
+//
+
+#ifndef THEMIND_MATCHMAKING_H
+#define THEMIND_MATCHMAKING_H
+
+#include <time.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include "Game.h"
+
+#define MAX_PLAYERS 4 // Seats of a table
+#define MAX_TABLES 64
+#define MAX_WAITING 256 // Players waiting for a seat
+#define MATCH_RELAX_DELAY 10 // Seconds before a waiting player accepts any table size
+#define MATCH_POLL_MS 1000 // Waiting players check their connection and the delays at this period
+
+#define MATCH_SEATED 0
+#define MATCH_SPECTATOR 1
+#define MATCH_REFUSED (-1)
+
+/**
+ * @brief Connection waiting for a seat, owned by its client thread.
+ */
+typedef struct {
+    int socket_fd;
+    char name[50];
+    int size; // Wanted table size, 0 for any
+    time_t since; // Arrival in the queue
+    Game *table; // Set by the scheduler once a seat is reserved
+    Player *player; // Created by the executor of the table
+} WaitingPlayer;
+
+/**
+ * @struct Matchmaker
+ * @brief Tables of the server and the queue of players waiting for a seat.
+ *
+ * Players are seated, in arrival order, in a lobby table of the size they asked for. A new table is
+ * opened when enough players wait for the same size. After MATCH_RELAX_DELAY seconds a player accepts
+ * any open table, or gets a new one, so the waiting time stays bounded while tables are available.
+ * Tables are only created, never destroyed before the shutdown : a Game pointer stays valid.
+ * The matchmaker only reserves seats from the count published by each executor, which creates the player
+ * on ROOM_JOIN or refuses the seat if the table changed meanwhile.
+ */
+typedef struct {
+    Game *tables[MAX_TABLES];
+    int nb_tables;
+    WaitingPlayer *queue[MAX_WAITING]; // FIFO
+    int nb_waiting;
+    bool running;
+    room_handler handler; // Handler of the executor of every table
+    pthread_mutex_t mutex;
+    pthread_cond_t cond; // Signaled when players are seated or at shutdown
+} Matchmaker;
+
+Matchmaker *create_matchmaker(room_handler handler);
+void free_matchmaker(Matchmaker *mm);
+void stop_matchmaker(Matchmaker *mm);
+void stop_tables(Matchmaker *mm);
+
+int parse_handshake(char *line, int *size, int *table_id);
+Game *get_table(Matchmaker *mm, int table_id);
+int join_table(Matchmaker *mm, int socket_fd, const char *name, int size, int table_id, int admin, Game **game, Player **player);
+void leave_table(Matchmaker *mm, Game *g, Player *p);
+void update_seats(Matchmaker *mm, Game *g);
+Player *accept_seat(Matchmaker *mm, Game *g, int socket_fd, const char *name);
+
+#endif //THEMIND_MATCHMAKING_H
@@ -0,0 +1,108 @@
+//
+// Created by erwan on 19/10/2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <stdatomic.h>
+#include "memstats.h"
+
+/**
+ * @brief Allocation counters of one subsystem, updated without lock.
+ */
+typedef struct {
+    atomic_ulong allocs; // Number of allocations
+    atomic_ulong frees; // Number of frees
+    atomic_size_t live; // Bytes currently allocated
+    atomic_size_t peak; // High-water mark of live
+    atomic_size_t total; // Bytes allocated since the start
+} MemCounters;
+
+static MemCounters counters[MEM_SUBSYSTEMS];
+static const char *names[MEM_SUBSYSTEMS] = {"game", "players", "queue", "stats", "network"};
+
+static void count_alloc(int subsystem, void *ptr) {
+    if (ptr == NULL || subsystem < 0 || subsystem >= MEM_SUBSYSTEMS) return;
+    MemCounters *c = &counters[subsystem];
+    size_t size = malloc_usable_size(ptr);
+    atomic_fetch_add_explicit(&c->allocs, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&c->total, size, memory_order_relaxed);
+    size_t live = atomic_fetch_add_explicit(&c->live, size, memory_order_relaxed) + size;
+    size_t peak = atomic_load_explicit(&c->peak, memory_order_relaxed);
+    while (live > peak && !atomic_compare_exchange_weak_explicit(&c->peak, &peak, live,
+                                                                 memory_order_relaxed, memory_order_relaxed));
+}
+
+static void count_free(int subsystem, void *ptr) {
+    if (ptr == NULL || subsystem < 0 || subsystem >= MEM_SUBSYSTEMS) return;
+    MemCounters *c = &counters[subsystem];
+    atomic_fetch_add_explicit(&c->frees, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&c->live, malloc_usable_size(ptr), memory_order_relaxed);
+}
+
+void *mem_malloc(int subsystem, size_t size) {
+    void *ptr = malloc(size);
+    count_alloc(subsystem, ptr);
+    return ptr;
+}
+
+void *mem_calloc(int subsystem, size_t nmemb, size_t size) {
+    void *ptr = calloc(nmemb, size);
+    count_alloc(subsystem, ptr);
+    return ptr;
+}
+
+/**
+ * @brief Counted realloc, counted as one free of the old block and one allocation of the new one.
+ */
+void *mem_realloc(int subsystem, void *ptr, size_t size) {
+    size_t old_size = ptr ? malloc_usable_size(ptr) : 0;
+    void *new_ptr = realloc(ptr, size);
+    if (new_ptr == NULL) return NULL;
+    if (ptr) {
+        atomic_fetch_add_explicit(&counters[subsystem].frees, 1, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&counters[subsystem].live, old_size, memory_order_relaxed);
+    }
+    count_alloc(subsystem, new_ptr);
+    return new_ptr;
+}
+
+char *mem_strdup(int subsystem, const char *s) {
+    char *copy = strdup(s);
+    count_alloc(subsystem, copy);
+    return copy;
+}
+
+void mem_free(int subsystem, void *ptr) {
+    count_free(subsystem, ptr);
+    free(ptr);
+}
+
+/**
+ * @brief Bytes currently allocated by a subsystem.
+ */
+size_t mem_live_bytes(int subsystem) {
+    return atomic_load(&counters[subsystem].live);
+}
+
+/**
+ * @brief Format the counters of every subsystem.
+ * @param buffer Destination buffer.
+ * @param size Size of the buffer.
+ * @return Length of the report, as snprintf.
+ */
+int mem_report(char *buffer, size_t size) {
+    size_t len = 0;
+    len += snprintf(buffer + len, size - len, "------ Mémoire ------\n%-8s %10s %10s %10s %10s %12s\n",
+                    "module", "allocs", "frees", "vivant(o)", "pic(o)", "total(o)");
+    for (int i = 0; i < MEM_SUBSYSTEMS && len < size; ++i) {
+        MemCounters *c = &counters[i];
+        len += snprintf(buffer + len, size - len, "%-8s %10lu %10lu %10zu %10zu %12zu\n", names[i],
+                        atomic_load(&c->allocs), atomic_load(&c->frees), atomic_load(&c->live),
+                        atomic_load(&c->peak), atomic_load(&c->total));
+    }
+    if (len < size) len += snprintf(buffer + len, size - len, "---------------------\n");
+    return (int)len;
+}
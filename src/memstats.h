@@ -0,0 +1,33 @@
+//
+// Created by erwan on 19/10/2026.
+//
+
+#ifndef THEMIND_MEMSTATS_H
+#define THEMIND_MEMSTATS_H
+
+#include <stddef.h>
+
+/**
+ * @brief Subsystems owning the allocations of the server.
+ */
+#define MEM_GAME 0 // Game tables, boards
+#define MEM_PLAYERS 1 // Players, player lists, hands
+#define MEM_QUEUE 2 // Card queues
+#define MEM_STATS 3 // GameData, rank and top10
+#define MEM_NETWORK 4 // Connections, thread arguments, rendered messages
+#define MEM_SUBSYSTEMS 5
+
+/*
+ * Counted allocation functions, sizes are taken from malloc_usable_size
+ * so that a free always removes what the allocation added.
+ */
+void *mem_malloc(int subsystem, size_t size);
+void *mem_calloc(int subsystem, size_t nmemb, size_t size);
+void *mem_realloc(int subsystem, void *ptr, size_t size);
+char *mem_strdup(int subsystem, const char *s);
+void mem_free(int subsystem, void *ptr);
+
+size_t mem_live_bytes(int subsystem);
+int mem_report(char *buffer, size_t size);
+
+#endif //THEMIND_MEMSTATS_H
@@ -0,0 +1,141 @@
+//
+// Created by erwan on 19/10/2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include "messages.h"
+#include "utils.h"
+#include "ANSI-color-codes.h"
+
+#define SEG(s) {s, sizeof(s) - 1}
+
+// Same text for every style.
+#define TEXT(a) {{0, {SEG(a)}}, {0, {SEG(a)}}}
+#define TEXT1(a, b) {{1, {SEG(a), SEG(b)}}, {1, {SEG(a), SEG(b)}}}
+
+// Colored text, the plain style drops the escape codes.
+#define STYLED(color, a) {{0, {SEG(color a CRESET)}}, {0, {SEG(a)}}}
+#define STYLED1(color, a, b) {{1, {SEG(color a), SEG(b CRESET)}}, {1, {SEG(a), SEG(b)}}}
+#define STYLED2(color, a, b, c) {{2, {SEG(color a), SEG(b), SEG(c CRESET)}}, {2, {SEG(a), SEG(b), SEG(c)}}}
+
+/**
+ * @brief Every message of the server, in each style.
+ *
+ * Constant messages are sent as they are, the others are spliced with their arguments without any format parsing.
+ */
+static const MsgTemplate catalog[MSG_COUNT][MSG_STYLES] = {
+    [MSG_WELCOME] = TEXT("Bienvenue sur TheMind ! \nEnvoyé votre nom, suivi si vous le souhaitez de la taille de table (1-4) ou de @numéro de table\n"),
+    [MSG_BAD_HANDSHAKE] = TEXT("Taille de table invalide, vous rejoindrez la première table disponible.\n"),
+    [MSG_SERVER_FULL] = TEXT("Le serveur est plein. Veuillez réessayer plus tard.\n"),
+    [MSG_TABLE_BUSY] = TEXT("Une partie est déja en cours. Veuillez réessayer plus tard.\n"),
+    [MSG_SPECTATOR] = TEXT("La table est occupée, vous êtes spectateur : vous verrez les cartes jouées, le plateau et les résultats.\n"),
+    [MSG_UNKNOWN_TABLE] = TEXT("Cette table n'existe pas.\n"),
+    [MSG_WAITING] = TEXT1("En attente d'une table (", " joueur(s) en attente)...\n"),
+    [MSG_SEATED] = TEXT1("Vous êtes à la table ", ".\n"),
+    [MSG_SESSION] = TEXT1("Jeton de session : ", "\n"),
+    [MSG_RESUMED] = TEXT1("Session reprise à la table ", ".\n"),
+    [MSG_RESUME_FAILED] = TEXT("Session inconnue ou expirée.\n"),
+
+    [MSG_JOINED] = STYLED1(GRN, "\n", " a rejoint !\n\n"),
+    [MSG_LEFT] = STYLED1(GRN, "\n", " a quitté!\n\n"),
+    [MSG_HELD] = STYLED2(YEL, "\n", " est déconnecté, sa place est gardée ", " s\n\n"),
+    [MSG_BACK] = STYLED1(GRN, "\n", " est de retour !\n\n"),
+    [MSG_RESUME_PLAY] = STYLED1(GRN, "La manche continue, dernière carte jouée : ", "\n"),
+    [MSG_GAME_START] = STYLED2(GRN, "\n", " a lancé la partie ! (joueurs : ", ")\n\n"),
+    [MSG_ROUND_START] = STYLED2(GRN, "\n", " a lancé le round (niveau :", ")\n\n"),
+    [MSG_COUNTDOWN] = STYLED(GRN, "\nLa partie vas commencer dans : "),
+    [MSG_COUNTDOWN_STEP] = STYLED1(GRN, "", " "),
+    [MSG_COUNTDOWN_GO] = STYLED(GRN, "Go !\n\n"),
+    [MSG_HAND_CARD] = STYLED1(BLK, "Carte : ", "\n"),
+    [MSG_PLAY] = STYLED2(GRN, "\n", " -> ", "\n\n"),
+    [MSG_DELTA_BOARD] = STYLED2(YEL, "Plateau [", "] = ", "\n"),
+    [MSG_DELTA_HAND] = STYLED1(MAG, "Cartes : -", "\n"),
+    [MSG_ROUND_WON] = STYLED1(GRN, "\nBravo vous avez gagné la manche ", "\n\n"),
+    [MSG_ROUND_LOST] = STYLED1(GRN, "\nLa manche ", " est perdu !\n\n"),
+    [MSG_GAME_STOPPED] = STYLED1(GRN, "\n", " a mis fin a la partie, retour au lobby\n\n"),
+    [MSG_NEW_GAME] = STYLED(GRN, "\nPrêt pour une nouvelle partie ?\n\n"),
+    [MSG_STATS_FILE] = STYLED2(GRN, "\nLe fichier de statistiques est disponible. \nNom du fichier : ",
+                               ".pdf \nPour le récupérer, utiliser la commande : getfile ",
+                               ".pdf sur le port du serveur + 1\n\n"),
+    [MSG_STATS_FAILED] = STYLED(RED, "\nLes statistiques de la partie n'ont pas pu être enregistrées.\n\n"),
+    [MSG_SHUTDOWN] = STYLED(RED, "\nLe serveur va se fermer, vous allez être déconnecté.\n\n"),
+
+    [MSG_GAME_RUNNING] = STYLED(RED, "La partie est déjà en cours\n"),
+    [MSG_NOT_READY] = STYLED(RED, "Tous les joueurs ne sont pas prêt !\n"),
+    [MSG_IN_ROUND] = STYLED(RED, "Vous êtes au milieu d'une manche !\n"),
+    [MSG_COUNTDOWN_RUNNING] = STYLED(RED, "Attendez la fin du compte à rebours !\n"),
+    [MSG_NO_CARD] = STYLED1(RED, "Vous n'avez pas la carte ", "\n"),
+    [MSG_ROUND_RUNNING] = STYLED(RED, "Une manche est en cours !\n"),
+    [MSG_LOBBY_FULL] = STYLED(RED, "Le lobby est déja plein !\n"),
+    [MSG_ROBOT_LOBBY_ONLY] = STYLED(RED, "Vous ne pouvez ajouter un robot uniquement dans le lobby\n"),
+    [MSG_ADMIN_ONLY] = STYLED(RED, "Commande réservée à l'administrateur\n"),
+    [MSG_COLOR_ON] = STYLED(GRN, "Couleurs activées\n"),
+    [MSG_COLOR_OFF] = TEXT("Couleurs désactivées\n"),
+    [MSG_DELTA_ON] = STYLED(GRN, "Mises à jour incrémentales activées, `state` pour l'écran complet\n"),
+    [MSG_DELTA_OFF] = STYLED(GRN, "Mises à jour complètes activées\n"),
+    [MSG_NO_PROFILE] = STYLED1(RED, "Aucun profil pour ", "\n"),
+};
+
+/**
+ * @brief Get a message of the catalog in a style.
+ *
+ * Constant messages are returned from the catalog without any copy.
+ *
+ * @param out Buffer for the messages with arguments.
+ * @param size Size of the buffer, MSG_SIZE is enough for every message.
+ * @param args Arguments of the message, in order, NULL if none.
+ * @param len Length of the message.
+ * @return The message, not null terminated.
+ */
+const char *msg_render(char *out, int size, int id, int style, const MsgArg *args, int *len) {
+    const MsgTemplate *t = &catalog[id][style];
+    if (t->nb_args == 0) {
+        *len = t->seg[0].len;
+        return t->seg[0].text;
+    }
+    StrBuilder sb; // Truncated to the buffer
+    sb_init(&sb, out, size);
+    sb_append(&sb, t->seg[0].text, t->seg[0].len);
+    for (int i = 0; i < t->nb_args; ++i) {
+        if (args[i].str != NULL) {
+            sb_str(&sb, args[i].str);
+        } else {
+            sb_int(&sb, args[i].num);
+        }
+        sb_append(&sb, t->seg[i + 1].text, t->seg[i + 1].len);
+    }
+    out[sb.len] = '\0';
+    *len = sb.len;
+    return out;
+}
+
+/**
+ * @brief Send a message of the catalog on a socket, before the client has a player.
+ * @return The result of send.
+ */
+int msg_send(int fd, int id, const MsgArg *args) {
+    char buffer[MSG_SIZE];
+    int len;
+    const char *msg = msg_render(buffer, sizeof(buffer), id, MSG_COLOR, args, &len);
+    return (int)send(fd, msg, len, 0);
+}
+
+/**
+ * @brief Copy a message without its ANSI escape sequences.
+ * @param out Buffer of at least len bytes.
+ * @return Length of the copy.
+ */
+int msg_strip(char *out, const char *msg, int len) {
+    int used = 0;
+    for (int i = 0; i < len; ++i) {
+        if (msg[i] == '\033' && i + 1 < len && msg[i + 1] == '[') {
+            i += 2;
+            while (i < len && (msg[i] < 0x40 || msg[i] > 0x7E)) i++; // Up to the final byte
+            continue;
+        }
+        out[used++] = msg[i];
+    }
+    return used;
+}
@@ -0,0 +1,102 @@
+//
+// Created by erwan on 19/10/2026.
+//
+
+#ifndef THEMIND_MESSAGES_H
+#define THEMIND_MESSAGES_H
+
+#define MSG_COLOR 0 // ANSI colors, default style of a client
+#define MSG_PLAIN 1 // Without escape codes
+#define MSG_STYLES 2
+#define MSG_MAX_ARGS 2
+#define MSG_SIZE 512 // Largest rendered catalog message
+
+/**
+ * @brief Messages of the server, their texts are in the catalog of messages.c.
+ */
+enum {
+    // Matchmaking
+    MSG_WELCOME,
+    MSG_BAD_HANDSHAKE,
+    MSG_SERVER_FULL,
+    MSG_TABLE_BUSY,
+    MSG_SPECTATOR,
+    MSG_UNKNOWN_TABLE,
+    MSG_WAITING, // nb waiting
+    MSG_SEATED, // table
+    MSG_SESSION, // token
+    MSG_RESUMED, // table
+    MSG_RESUME_FAILED,
+    // Table events
+    MSG_JOINED, // name
+    MSG_LEFT, // name
+    MSG_HELD, // name, seconds
+    MSG_BACK, // name
+    MSG_RESUME_PLAY, // last card played
+    MSG_GAME_START, // name, nb players
+    MSG_ROUND_START, // name, level
+    MSG_COUNTDOWN,
+    MSG_COUNTDOWN_STEP, // seconds
+    MSG_COUNTDOWN_GO,
+    MSG_HAND_CARD, // card
+    MSG_PLAY, // name, card
+    MSG_DELTA_BOARD, // slot, card
+    MSG_DELTA_HAND, // card
+    MSG_ROUND_WON, // level
+    MSG_ROUND_LOST, // level
+    MSG_GAME_STOPPED, // name
+    MSG_NEW_GAME,
+    MSG_STATS_FILE, // file name, file name
+    MSG_STATS_FAILED,
+    MSG_SHUTDOWN,
+    // Command errors
+    MSG_GAME_RUNNING,
+    MSG_NOT_READY,
+    MSG_IN_ROUND,
+    MSG_COUNTDOWN_RUNNING,
+    MSG_NO_CARD, // card
+    MSG_ROUND_RUNNING,
+    MSG_LOBBY_FULL,
+    MSG_ROBOT_LOBBY_ONLY,
+    MSG_ADMIN_ONLY,
+    MSG_COLOR_ON,
+    MSG_COLOR_OFF,
+    MSG_DELTA_ON,
+    MSG_DELTA_OFF,
+    MSG_NO_PROFILE, // name
+    MSG_COUNT
+};
+
+/**
+ * @brief Literal part of a message, its length is computed at compile time.
+ */
+typedef struct {
+    const char *text;
+    int len;
+} MsgSeg;
+
+/**
+ * @brief Message split around its arguments : seg[0] arg[0] seg[1] arg[1] seg[2].
+ */
+typedef struct {
+    int nb_args;
+    MsgSeg seg[MSG_MAX_ARGS + 1];
+} MsgTemplate;
+
+/**
+ * @brief Argument of a message, a name when str is set, an integer otherwise.
+ */
+typedef struct {
+    const char *str;
+    int num;
+} MsgArg;
+
+#define ARG_S(s) ((MsgArg){.str = (s), .num = 0})
+#define ARG_D(d) ((MsgArg){.str = NULL, .num = (d)})
+#define MSG_ARGS(...) ((const MsgArg[]){__VA_ARGS__})
+
+const char *msg_render(char *out, int size, int id, int style, const MsgArg *args, int *len);
+int msg_send(int fd, int id, const MsgArg *args);
+int msg_strip(char *out, const char *msg, int len);
+
+#endif //THEMIND_MESSAGES_H
@@ -6,6 +6,213 @@
 #include "playersRessources.h"
 
 
+/*
+ * Output coalescing
+ */
+
+static _Thread_local OutputTick *current_tick = NULL;
+
+/**
+ * @brief Send the whole iovec array, a blocking writev may still be cut by a signal.
+ */
+static void write_all(int fd, struct iovec *iov, int count) {
+    while (count > 0) {
+        ssize_t written = writev(fd, iov, count);
+        if (written < 0) {
+            perror("Erreur lors de l'envoi du message à un joueur");
+            return;
+        }
+        while (count > 0 && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char *)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+}
+
+static void flush_player(Player *p) {
+    if (p->out_count == 0) return;
+    write_all(p->socket_fd, p->out, p->out_count);
+    p->out_count = 0;
+}
+
+/**
+ * @brief Open a tick on the calling thread, the output is kept until tick_flush or tick_end.
+ */
+void tick_begin(OutputTick *tick) {
+    tick->used = 0;
+    tick->nb_pending = 0;
+    current_tick = tick;
+}
+
+static void flush_pending(OutputTick *tick) {
+    for (int i = 0; i < tick->nb_pending; ++i) {
+        flush_player(tick->pending[i]);
+    }
+    tick->nb_pending = 0;
+}
+
+/**
+ * @brief Send the pending output of every player, one writev each. Nothing to do without an open tick.
+ */
+void tick_flush(void) {
+    OutputTick *tick = current_tick;
+    if (tick == NULL) return;
+    flush_pending(tick);
+    tick->used = 0;
+}
+
+void tick_end(void) {
+    tick_flush();
+    current_tick = NULL;
+}
+
+/**
+ * @brief Copy a message in the arena of the tick, flushing the tick if it is full.
+ * @return The copy, or NULL if the message is larger than the arena.
+ */
+static char *tick_copy(OutputTick *tick, const char *msg, int length) {
+    if (length > TICK_ARENA_SIZE) return NULL;
+    if (tick->used + length > TICK_ARENA_SIZE) tick_flush();
+    char *copy = tick->arena + tick->used;
+    memcpy(copy, msg, length);
+    tick->used += length;
+    return copy;
+}
+
+/**
+ * @brief Queue a message, already in the arena, for a player.
+ */
+static void tick_queue(OutputTick *tick, Player *p, char *data, int length) {
+    if (p->out_count == 0) {
+        if (tick->nb_pending == TICK_MAX_PENDING) flush_pending(tick); // The arena is kept, data stays valid
+        tick->pending[tick->nb_pending++] = p;
+    } else if (p->out_count == OUT_IOV_MAX) {
+        flush_player(p); // Still in the pending list
+    }
+    p->out[p->out_count].iov_base = data;
+    p->out[p->out_count].iov_len = length;
+    p->out_count++;
+}
+
+/**
+ * @brief Forget a player leaving during the tick, its pending output is dropped.
+ */
+static void tick_forget(Player *p) {
+    OutputTick *tick = current_tick;
+    p->out_count = 0;
+    if (tick == NULL) return;
+    for (int i = 0; i < tick->nb_pending; ++i) {
+        if (tick->pending[i] == p) {
+            tick->pending[i] = tick->pending[--tick->nb_pending];
+            return;
+        }
+    }
+}
+
+/*
+ * Snapshots of the PLAYER LIST
+ */
+
+/**
+ * @brief Take a spare snapshot, or allocate one while the table warms up. Called with the writer mutex held.
+ */
+static PlayerSnapshot *new_snapshot(PlayerList *pl, int count) {
+    PlayerSnapshot *snap = pl->spare;
+    if (snap != NULL) {
+        pl->spare = snap->next_retired;
+    } else {
+        snap = mem_malloc(MEM_PLAYERS,sizeof(PlayerSnapshot) + pl->max * sizeof(Player*));
+        if (snap == NULL) return NULL;
+    }
+    snap->next_retired = NULL;
+    snap->removed = NULL;
+    snap->seen_idle[0] = false;
+    snap->seen_idle[1] = false;
+    snap->count = count;
+    return snap;
+}
+
+/**
+ * @brief Give a player slot back to the pool, with a new generation.
+ */
+static void release_slot(PlayerList *pl, Player *p) {
+    if (p == NULL) return;
+    atomic_fetch_add(&p->gen,1);
+    pl->free_slots[pl->nb_free++] = p;
+}
+
+static void recycle_snapshot(PlayerList *pl, PlayerSnapshot *snap) {
+    release_slot(pl,snap->removed);
+    snap->removed = NULL;
+    snap->next_retired = pl->spare;
+    pl->spare = snap;
+}
+
+static void free_snapshots(PlayerSnapshot *snap) {
+    while (snap) {
+        PlayerSnapshot *next = snap->next_retired;
+        mem_free(MEM_PLAYERS,snap);
+        snap = next;
+    }
+}
+
+/**
+ * @brief Recycle the retired snapshots that no reader can still use.
+ *
+ * A reader holding a snapshot is counted in one of the two reader counters. Readers that register
+ * after the retirement only see a newer snapshot, so once both counters were seen at zero the
+ * snapshot is unreachable. Called with the writer mutex held.
+ */
+static void reclaim_snapshots(PlayerList *pl) {
+    PlayerSnapshot **link = &pl->retired;
+    while (*link) {
+        PlayerSnapshot *snap = *link;
+        for (int i = 0; i < 2; ++i) {
+            if (atomic_load(&pl->readers[i]) == 0) snap->seen_idle[i] = true;
+        }
+        if (snap->seen_idle[0] && snap->seen_idle[1]) {
+            *link = snap->next_retired;
+            recycle_snapshot(pl,snap);
+        } else {
+            link = &snap->next_retired;
+        }
+    }
+}
+
+/**
+ * @brief Replace the current snapshot, the old one is retired. Called with the writer mutex held.
+ * @param removed Player removed by this change, released with the old snapshot.
+ */
+static void publish_snapshot(PlayerList *pl, PlayerSnapshot *snap, Player *removed) {
+    PlayerSnapshot *old = atomic_exchange(&pl->snapshot,snap);
+    atomic_store(&pl->count,snap->count);
+    atomic_fetch_add(&pl->epoch,1); // New readers use the other counter
+    old->removed = removed;
+    old->next_retired = pl->retired;
+    pl->retired = old;
+    reclaim_snapshots(pl);
+}
+
+/**
+ * @brief Enter a read section and get the current players.
+ * @param slot Reader counter to give back to release_players.
+ * @return The snapshot, valid until release_players. Never blocks.
+ */
+PlayerSnapshot *read_players(PlayerList *pl, int *slot) {
+    *slot = (int)(atomic_load(&pl->epoch) & 1);
+    atomic_fetch_add(&pl->readers[*slot],1);
+    return atomic_load(&pl->snapshot);
+}
+
+void release_players(PlayerList *pl, int slot) {
+    atomic_fetch_sub(&pl->readers[slot],1);
+}
+
 /*
  * Creation and frees function on PLAYER
  */
@@ -13,7 +220,7 @@
 /**
  * @brief Creates a new player and adds them to the player list.
  *
- * Checks if the player list has reached its maximum capacity
+ * Checks if the player list has reached its maximum capacity. The player takes a free slot of the list.
  *
  * @param players Pointer to the player list.
  * @param socket_fd Socket descriptor of the player.
@@ -21,88 +228,107 @@
  *         or NULL if the player limit is reached or an error occurs.
  */
 Player* create_player(PlayerList* players, int socket_fd) {
-    if (players->count >= players->max) {
+    pthread_mutex_lock(&players->write_mutex);
+    PlayerSnapshot *old = atomic_load(&players->snapshot);
+    if (old->count >= players->max) {
+        pthread_mutex_unlock(&players->write_mutex);
         return NULL;  // Limite de joueurs atteinte
     }
-    pthread_rwlock_wrlock(&players->mutexRW);
 
-    Player *player = malloc(sizeof(Player));
+    if (players->nb_free == 0) reclaim_snapshots(players); // Slots of the players removed last
+    PlayerSnapshot *snap = players->nb_free > 0 ? new_snapshot(players,old->count + 1) : NULL;
+    if (snap == NULL) {
+        pthread_mutex_unlock(&players->write_mutex);
+        return NULL;
+    }
+    Player *player = players->free_slots[--players->nb_free];
     player->socket_fd = socket_fd;
     player->ready = 1;
-    player->id = players->count;
-    player->cards = NULL;
+    player->id = old->count;
+    reset_queue(&player->hand);
+    player->in_round = false;
+    player->admin = 0;
+    player->style = MSG_COLOR;
+    player->delta = false;
+    hist_reset(&player->reaction);
+    hist_reset(&player->round_reaction);
+    player->lost_card = false;
+    player->token[0] = '\0';
+    player->held_since = 0;
+    player->out_count = 0;
     snprintf(player->name,sizeof(player->name),"Anonyme%d",player->id);
 
-    players->players[players->count] = player;
-    players->count++;
+    memcpy(snap->players,old->players,old->count * sizeof(Player*));
+    snap->players[old->count] = player;
+    atomic_fetch_add(&players->ready_count,1);
+    publish_snapshot(players,snap,NULL);
 
-    pthread_rwlock_unlock(&players->mutexRW);
+    pthread_mutex_unlock(&players->write_mutex);
     return player;
 }
-/**
- * @brief Frees all dynamically allocated resources for a player and deletes the player structure.
- *
- * It also ensures that pointers are set to `NULL` after being freed to avoid accidental use.
- *
- * @param player A pointer to the `Player` structure to be freed.
- *               If `player` is `NULL`, the function does nothing.
- *
- * @note This function is intended to be used when completely removing a player,
- *       for example, during disconnection.
- */
-void free_player(Player* player) {
-    if (player == NULL) {
-        return;
-    }
-
-    if (player->cards != NULL) {
-        free(player->cards);
-        player->cards = NULL;
-    }
-
-    free(player);
-}
 /**
  * @brief Initializes a new player list with a defined maximum capacity.
  *
- * Allocates the necessary memory for the PlayerList structure and the dynamic
- * array of players, then initializes the read/write lock.
+ * Allocates the PlayerList structure, its player slots and an empty
+ * snapshot of players, then initializes the writer mutex.
+ * Twice max_players slots are kept, so that a seat is free again before the readers
+ * of the player who left it are done.
  *
  * @param max_players The maximum number of players allowed in the list.
  * @return A pointer to the new PlayerList structure, or NULL if an allocation fails.
  */
 PlayerList* init_pl(int max_players) {
-    PlayerList* players = malloc(sizeof(PlayerList));
+    PlayerList* players = mem_malloc(MEM_PLAYERS,sizeof(PlayerList));
     if (players == NULL) return NULL;
-
-    players->players = malloc(sizeof(Player) * max_players);
-    if (players->players == NULL) {
-        free(players);
+    players->max = max_players;
+    players->spare = NULL;
+
+    int nb_slots = 2 * max_players;
+    players->slots = mem_calloc(MEM_PLAYERS,nb_slots,sizeof(Player));
+    players->free_slots = mem_malloc(MEM_PLAYERS,nb_slots * sizeof(Player*));
+    PlayerSnapshot *snap = new_snapshot(players,0);
+    if (players->slots == NULL || players->free_slots == NULL || snap == NULL) {
+        mem_free(MEM_PLAYERS,players->slots);
+        mem_free(MEM_PLAYERS,players->free_slots);
+        mem_free(MEM_PLAYERS,snap);
+        mem_free(MEM_PLAYERS,players);
         return NULL;
     }
+    players->nb_free = 0;
+    for (int i = nb_slots - 1; i >= 0; --i) {
+        atomic_init(&players->slots[i].gen,0);
+        players->free_slots[players->nb_free++] = &players->slots[i];
+    }
 
-    players->count = 0;
-    players->max = max_players;
-    pthread_rwlock_init(&players->mutexRW, NULL);
+    atomic_init(&players->snapshot,snap);
+    atomic_init(&players->count,0);
+    atomic_init(&players->ready_count,0);
+    atomic_init(&players->epoch,0);
+    atomic_init(&players->readers[0],0);
+    atomic_init(&players->readers[1],0);
+    players->retired = NULL;
+    pthread_mutex_init(&players->write_mutex, NULL);
 
     return players;
 }
 /**
  * @brief Frees the memory allocated for the player list.
  *
- * Destroys the read/write lock, frees the player array, and
+ * Destroys the writer mutex, frees the player slots and every snapshot, and
  * then frees the PlayerList structure itself.
+ * @warning No reader must be in a read section.
  *
  * @param players Pointer to the player list to free.
  */
 void free_player_list(PlayerList* players){
     if(players){
-        pthread_rwlock_destroy(&players->mutexRW);
-        for (int i = 0; i < players->count - 1; ++i) {
-            free_player(players->players[i]);
-        }
-        free(players->players);
-        free(players);
+        pthread_mutex_destroy(&players->write_mutex);
+        mem_free(MEM_PLAYERS,atomic_load(&players->snapshot));
+        free_snapshots(players->retired);
+        free_snapshots(players->spare);
+        mem_free(MEM_PLAYERS,players->slots);
+        mem_free(MEM_PLAYERS,players->free_slots);
+        mem_free(MEM_PLAYERS,players);
     }
 }
 /**
@@ -110,92 +336,99 @@ void free_player_list(PlayerList* players){
  * @param pl The player list.
  */
 void disconnect_allP(PlayerList *pl) {
-    for (int i = 0; i < pl->count; ++i) {
-        close(pl->players[i]->socket_fd);
+    int slot;
+    PlayerSnapshot *snap = read_players(pl,&slot);
+    for (int i = 0; i < snap->count; ++i) {
+        if (snap->players[i]->socket_fd < 0) continue; // Seat held
+        shutdown(snap->players[i]->socket_fd,SHUT_RDWR); // The socket is closed when the player leaves
     }
+    release_players(pl,slot);
 }
 /**
- * @brief Initializes the cards array for all players in the PlayerList.
+ * @brief Close the connection of a player, its output still pending in the tick is dropped.
  *
- * This function allocates memory for the `cards` array of each player in the
- * `PlayerList`. The size of the `cards` array is determined by the `nb_cards`
- * parameter.
-
- * @param pl A pointer to the `PlayerList` structure containing the players.
- * @param nb_cards The number of cards to allocate for each player. Each
- *                 player's `cards` array will be of size `nb_cards` and
- *                 zero-initialized.
+ * The socket is unbound before being closed, so that no later flush writes to a reused descriptor.
+ */
+void close_player_socket(Player *p) {
+    tick_forget(p);
+    int fd = p->socket_fd;
+    p->socket_fd = -1;
+    if (fd >= 0) close(fd);
+}
+/**
+ * @brief Empties the hand of every player in the PlayerList and marks them as dealt in the round.
+ *
+ * Players seated later in the round keep `in_round` false and receive no card.
  *
- * @note If a player's `cards` array was already allocated, this function does
- *       not free the previous allocation, potentially leading to a memory leak.
- *       Ensure proper memory management before calling this function.
- */
-void init_player_card(PlayerList *pl, int nb_cards) {
-    pthread_rwlock_wrlock(&pl->mutexRW);
-    for (int i = 0; i < pl->count; ++i) {
-        pl->players[i]->cards = calloc(nb_cards,sizeof (int));
+ * @param pl A pointer to the `PlayerList` structure containing the players.
+ */
+void init_player_card(PlayerList *pl) {
+    int slot;
+    PlayerSnapshot *snap = read_players(pl,&slot);
+    for (int i = 0; i < snap->count; ++i) {
+        reset_queue(&snap->players[i]->hand);
+        snap->players[i]->in_round = true;
     }
-    pthread_rwlock_unlock(&pl->mutexRW);
+    release_players(pl,slot);
 }
 /**
- * @brief Frees the memory allocated for the `cards` array of all players in the PlayerList.
- *
- * This function iterates through the `PlayerList` and releases the memory allocated
- * for each player's `cards` array.
+ * @brief Empties the hand of every player in the PlayerList at the end of a round.
  *
  * @param pl A pointer to the `PlayerList` structure containing the players..
- *
- * @note After calling this function, the `cards` pointer of each player will be set
- *       to `NULL` to prevent dangling pointers.
  */
 void free_players_card(PlayerList *pl){
     if (pl == NULL) {
         fprintf(stderr, "Error: PlayerList is NULL\n");
         return;
     }
-    pthread_rwlock_wrlock(&pl->mutexRW);
-    for (int i = 0; i < pl->count; ++i) {
-        if (pl->players[i] != NULL && pl->players[i]->cards != NULL) {
-            free(pl->players[i]->cards);
-            pl->players[i]->cards = NULL;
-        }
+    int slot;
+    PlayerSnapshot *snap = read_players(pl,&slot);
+    for (int i = 0; i < snap->count; ++i) {
+        reset_queue(&snap->players[i]->hand);
+        snap->players[i]->in_round = false;
     }
-    pthread_rwlock_unlock(&pl->mutexRW);
+    release_players(pl,slot);
 }
 /**
  * @brief Removes a specific player from the player list.
  *
- * This function searches for a player in the list by their ID and removes
- * them if found. If the player is not the last one in the array, the last
- * player is moved to fill the empty slot, and their ID is updated.
+ * This function publishes a new snapshot without the player. If the player is
+ * not the last one in the array, the last player is moved to fill the empty
+ * slot, and their ID is updated. The player is freed once no reader can see it.
  *
  * @param players Pointer to the player list.
  * @param p Pointer to the player to remove.
- * @return 0 if the player was found and removed, -1 otherwise.
+ * @return 1 if the player was found and removed, 0 otherwise.
  */
 int remove_player(PlayerList* players, Player* p) {
-    pthread_rwlock_wrlock(&players->mutexRW);
-
-    int player_found = 0;
-    for (int i = 0; i < players->count; ++i) {
-        if (players->players[i]->id == p->id) {
-            player_found = 1;
-
-            free_player(p);
+    pthread_mutex_lock(&players->write_mutex);
+    PlayerSnapshot *old = atomic_load(&players->snapshot);
 
-            // Remplace le joueur supprimé par le dernier joueur de la liste
-            if (i != players->count - 1) {
-                players->players[i] = players->players[players->count - 1];
-                players->players[i]->id = i;  // Met à jour l'ID
-            }
-
-            players->count--;
+    int index = -1;
+    for (int i = 0; i < old->count; ++i) {
+        if (old->players[i] == p) {
+            index = i;
             break;
         }
     }
+    PlayerSnapshot *snap = index == -1 ? NULL : new_snapshot(players,old->count - 1);
+    if (snap == NULL) {
+        pthread_mutex_unlock(&players->write_mutex);
+        return 0;
+    }
+
+    // Remplace le joueur supprimé par le dernier joueur de la liste
+    memcpy(snap->players,old->players,snap->count * sizeof(Player*));
+    if (index != old->count - 1) {
+        snap->players[index] = old->players[old->count - 1];
+        snap->players[index]->id = index;  // Met à jour l'ID
+    }
+    if (p->ready) atomic_fetch_sub(&players->ready_count,1);
+    tick_forget(p);
+    publish_snapshot(players,snap,p); // p is released when no reader can see it anymore
 
-    pthread_rwlock_unlock(&players->mutexRW);
-    return player_found;
+    pthread_mutex_unlock(&players->write_mutex);
+    return 1;
 }
 /**
  * @brief Change ready state of a specific player.
@@ -212,9 +445,8 @@ int update_ready_player(PlayerList *players, Player *p, int state){
     if(p->ready == state)
         return 1;
 
-    pthread_rwlock_wrlock(&players->mutexRW);
-    p->ready = !p->ready;
-    pthread_rwlock_unlock(&players->mutexRW);
+    p->ready = state;
+    atomic_fetch_add(&players->ready_count,state ? 1 : -1);
     return 0;
 }
 /**
@@ -222,8 +454,7 @@ int update_ready_player(PlayerList *players, Player *p, int state){
  *
  * This function validates the provided name to ensure it meets the required
  * length constraints (between 3 and 49 characters). If valid, it updates
- * the player's name while holding a write lock on the `PlayerList` to ensure
- * thread safety. The function also removes any trailing newline character
+ * the player's name while holding the writer mutex of the `PlayerList`. The function also removes any trailing newline character
  * from the input name.
  *
  * @param players A pointer to the `PlayerList` structure containing the player.
@@ -238,10 +469,10 @@ int set_player_name(PlayerList *players, Player *p, char* name){
     if(strlen(name) >= 50 || strlen(name) < 3)
         return -1;
 
-    pthread_rwlock_wrlock(&players->mutexRW);
+    pthread_mutex_lock(&players->write_mutex);
     strncpy(p->name, name, sizeof(p->name) - 1);
     p->name[strcspn(p->name, "\n")] = '\0';
-    pthread_rwlock_unlock(&players->mutexRW);
+    pthread_mutex_unlock(&players->write_mutex);
     return 0;
 }
 /**
@@ -265,30 +496,115 @@ int broadcast_message(PlayerList* players, Player* exclude_player, int params, c
         perror("Erreur de formatage du message");
         return -1;
     }
+    if (length >= BUFSIZ) length = BUFSIZ - 1; // Tronqué
+
+    return broadcast_raw(players, exclude_player, params, buffer, length);
+}
+/**
+ * @brief Sends a message to the players of a style, the message is copied in the tick only if one of them gets it.
+ */
+static void send_style(PlayerSnapshot *snap, Player* exclude_player, int style, const char* msg, int length) {
+    OutputTick *tick = current_tick;
+    char *copy = NULL;
+    bool copied = false;
+    for (int i = 0; i < snap->count; ++i) {
+        Player* current_player = snap->players[i];
+        if (current_player == exclude_player || current_player->style != style) continue;
+        if (current_player->socket_fd < 0) continue; // Seat held, disconnected
+        if (tick && !copied) {
+            // Dans un tick, le message est copié une fois et envoyé au flush
+            copy = tick_copy(tick, msg, length);
+            copied = true;
+            if (copy == NULL) tick_flush(); // Too large, sent directly after the pending output
+        }
+        if (copy) {
+            tick_queue(tick, current_player, copy, length);
+        } else if (send(current_player->socket_fd, msg, length, 0) == -1) {
+            perror("Erreur lors de l'envoi du message à un joueur");
+        }
+    }
+}
 
-    // Bloquer en lecture le mutex
-    pthread_rwlock_rdlock(&players->mutexRW);
+static bool has_style(PlayerSnapshot *snap, Player* exclude_player, int style) {
+    for (int i = 0; i < snap->count; ++i) {
+        if (snap->players[i] != exclude_player && snap->players[i]->style == style) return true;
+    }
+    return false;
+}
 
-    // Diffuser le message à tous les joueurs, sauf le joueur exclu
-    for (int i = 0; i < players->count; ++i) {
-        Player* current_player = players->players[i];
-        if (exclude_player == NULL || current_player->id != exclude_player->id) {
-            if (send(current_player->socket_fd, buffer, length, 0) == -1) {
-                perror("Erreur lors de l'envoi du message à un joueur");
-            }
+/**
+ * @brief Sends an already formatted message to all players, except one if specified.
+ *
+ * The escape codes are removed, once, for the players who asked for plain messages.
+ *
+ * @param players Pointer to the player list.
+ * @param exclude_player Player to exclude, or NULL.
+ * @param params B_CONSOLE to also print the message on the server console.
+ * @param msg Message to send.
+ * @param length Length of the message.
+ * @return 0 on success.
+ */
+int broadcast_raw(PlayerList* players, Player* exclude_player, int params, const char* msg, int length) {
+    TRACE_BEGIN(span);
+    // Section de lecture : aucun verrou pendant les send()
+    int slot;
+    PlayerSnapshot *snap = read_players(players,&slot);
+
+    send_style(snap, exclude_player, MSG_COLOR, msg, length);
+    if (has_style(snap, exclude_player, MSG_PLAIN)) {
+        char plain[BUFSIZ];
+        if (length <= (int)sizeof(plain)) {
+            send_style(snap, exclude_player, MSG_PLAIN, plain, msg_strip(plain, msg, length));
+        } else {
+            send_style(snap, exclude_player, MSG_PLAIN, msg, length);
         }
     }
+    release_players(players,slot);
 
     // Afficher le message dans la console si le paramètre est défini
     if (params == B_CONSOLE) {
-        printf("%s", buffer);
+        printf("%.*s", length, msg);
     }
 
-    // Débloquer le mutex
-    pthread_rwlock_unlock(&players->mutexRW);
+    TRACE_END(span,"broadcast_message");
+    return 0;
+}
+/**
+ * @brief Sends a message already rendered in every style, each player gets the one of its style.
+ * @param msgs Message of each style.
+ * @param lengths Length of each message.
+ * @return 0 on success.
+ */
+int broadcast_styled(PlayerList* players, Player* exclude_player, int params, const char* msgs[MSG_STYLES], const int lengths[MSG_STYLES]) {
+    TRACE_BEGIN(span);
+    int slot;
+    PlayerSnapshot *snap = read_players(players,&slot);
+    for (int style = 0; style < MSG_STYLES; ++style) {
+        send_style(snap, exclude_player, style, msgs[style], lengths[style]);
+    }
+    release_players(players,slot);
 
+    if (params == B_CONSOLE) {
+        printf("%.*s", lengths[MSG_COLOR], msgs[MSG_COLOR]);
+    }
+    TRACE_END(span,"broadcast_message");
     return 0;
 }
+/**
+ * @brief Sends a message of the catalog to all players, except one if specified.
+ * @param id Message of the catalog.
+ * @param args Arguments of the message, NULL if none.
+ * @return 0 on success.
+ */
+int broadcast_msg(PlayerList* players, Player* exclude_player, int params, int id, const MsgArg *args) {
+    char buffers[MSG_STYLES][MSG_SIZE];
+    const char *msgs[MSG_STYLES];
+    int lengths[MSG_STYLES];
+    for (int style = 0; style < MSG_STYLES; ++style) {
+        msgs[style] = msg_render(buffers[style], MSG_SIZE, id, style, args, &lengths[style]);
+    }
+    return broadcast_styled(players, exclude_player, params, msgs, lengths);
+}
 /**
  * @brief Send format message to one player.
  * @param player Player to send the message on his socket.
@@ -313,38 +629,60 @@ void send_p(Player *player, const char* format, ...) {
         return;
     }
 
+    if (length >= BUFSIZ) length = BUFSIZ - 1; // Tronqué
+    send_raw(player, buffer, length);
+}
+static void send_out(Player *player, const char* msg, int length) {
+    if (player->socket_fd < 0) return; // Seat held, disconnected
+    // Dans un tick, le message part avec les autres au flush
+    OutputTick *tick = current_tick;
+    char *copy = tick ? tick_copy(tick, msg, length) : NULL;
+    if (tick && copy == NULL) tick_flush();
+    if (copy) {
+        tick_queue(tick, player, copy, length);
+        return;
+    }
+
     // Envoyer le message via le socket
-    if (send(player->socket_fd, buffer, length, 0) == -1) {
+    if (send(player->socket_fd, msg, length, 0) == -1) {
         perror("Erreur lors de l'envoi du message");
     }
 }
+/**
+ * @brief Sends an already formatted message to a player, without the escape codes if it asked for plain messages.
+ */
+void send_raw(Player *player, const char* msg, int length) {
+    char plain[BUFSIZ];
+    if (player->style == MSG_PLAIN && length <= (int)sizeof(plain)) {
+        send_out(player, plain, msg_strip(plain, msg, length));
+    } else {
+        send_out(player, msg, length);
+    }
+}
+/**
+ * @brief Sends a message of the catalog to a player, in its style.
+ * @param id Message of the catalog.
+ * @param args Arguments of the message, NULL if none.
+ */
+void send_msg(Player *player, int id, const MsgArg *args) {
+    char buffer[MSG_SIZE];
+    int length;
+    const char *msg = msg_render(buffer, sizeof(buffer), id, player->style, args, &length);
+    send_out(player, msg, length);
+}
 /**
  * @brief test is the list is full
  * @param playerList Pointer to the player list
  * @return 1 if the list is full, 0 if theres is still place
  */
 int is_full(PlayerList *playerList){
-    pthread_rwlock_rdlock(&playerList->mutexRW);
-    if(playerList->count == playerList->max){
-        pthread_rwlock_unlock(&playerList->mutexRW);
-        return 0;
-    }
-    pthread_rwlock_unlock(&playerList->mutexRW);
-    return 1;
+    return atomic_load(&playerList->count) == playerList->max ? 0 : 1;
 }
 /**
- * @brief Calc the number of player ready.
+ * @brief Number of player ready, kept up to date by an atomic counter.
  * @param pl Pointer to the list of player.
  * @return Number of player's ready.
  */
 int get_ready_count(PlayerList *pl){
-    pthread_rwlock_rdlock(&pl->mutexRW);
-    int count = 0;
-    for (int i = 0; i < pl->count; ++i) {
-        if(pl->players[i]->ready == 1)
-            count++;
-    }
-    pthread_rwlock_unlock(&pl->mutexRW);
-
-    return count;
+    return atomic_load(&pl->ready_count);
 }
@@ -10,30 +10,98 @@
 #include <unistd.h>
 #include <malloc.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <stdarg.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "trace.h"
+#include "memstats.h"
+#include "messages.h"
+#include "queue.h"
+#include "histogram.h"
 
 #define B_CONSOLE 1
+#define SESSION_TOKEN_SIZE 32
+#define OUT_IOV_MAX 32 // Pending messages of a player in a tick
+#define TICK_ARENA_SIZE 65536 // Messages of a tick
+#define TICK_MAX_PENDING 16 // Players with pending output in a tick
 
 typedef struct {
     int socket_fd; // Socket associate for the player
     char name[50];
     int ready; // boolean 1 is ready, 0 not ready
     int id; // Unique id
-    int* cards; // Decks of cards,
+    Queue hand; // Cards of the player, sorted bitset
+    bool in_round; // Dealt in the current round, false if seated after its start
+    int admin; // 1 if connected from the server host, allowed to use admin commands
+    int style; // MSG_COLOR or MSG_PLAIN, chosen by the client
+    bool delta; // Gets only the changes of the board during a round, chosen by the client
+    Histogram reaction; // Reaction times of the player in the current game, in ns
+    Histogram round_reaction; // Reaction times of the current round, added to the profile at its end
+    bool lost_card; // Played the card that lost the current round
+    char token[SESSION_TOKEN_SIZE]; // Session token, to take the seat back after a disconnection
+    time_t held_since; // Disconnection time while the seat is held, 0 otherwise
+    struct iovec out[OUT_IOV_MAX]; // Output of the current tick, pointing in the tick arena
+    int out_count;
+    atomic_uint gen; // Generation of the slot, incremented when the player is released
 }Player;
 
+/**
+ * @brief Output of one processing tick of a table.
+ *
+ * While a tick is open on a thread, broadcast_message and send_p copy each message once in the
+ * arena and queue it for its recipients. tick_flush sends the pending output of every player with
+ * a single writev, so that a game event costs one segment per client.
+ */
+typedef struct {
+    char arena[TICK_ARENA_SIZE];
+    size_t used;
+    Player *pending[TICK_MAX_PENDING]; // Players with queued output
+    int nb_pending;
+}OutputTick;
+
+/**
+ * @brief Immutable array of the players, replaced as a whole when a player joins or leaves.
+ */
+typedef struct PlayerSnapshot {
+    struct PlayerSnapshot *next_retired; // Retired list, writer side
+    Player *removed; // Player released with this snapshot, once no reader can see it
+    bool seen_idle[2]; // Reader counters seen at zero since the retirement
+    int count;
+    Player *players[]; // Players list
+}PlayerSnapshot;
+
+/**
+ * @brief Players of a table, read through RCU-style snapshots.
+ *
+ * Readers register in the reader counter of the current epoch and use the published snapshot,
+ * without any lock. Writers are serialized by a mutex, publish a new snapshot and bump the epoch,
+ * so that new readers use the other counter. An old snapshot is recycled once both counters were
+ * seen at zero after its retirement : readers never block writers, writers never wait for readers.
+ *
+ * Players live in preallocated slots and snapshots are reused, so joins and leaves don't allocate
+ * once the table is warm. A released slot gets a new generation : a pointer kept with the
+ * generation it was taken at tells a stale player from the one reusing its slot.
+ */
 typedef struct {
-    Player **players; // Players list
-    int count; // Number of players
+    _Atomic(PlayerSnapshot *) snapshot; // Current players
+    atomic_int count; // Number of players
+    atomic_int ready_count; // Number of ready players
     int max; // Max players allowed
-    pthread_rwlock_t mutexRW; // Mutex to ensure write and read operation.
+    atomic_uint epoch; // Incremented on every published snapshot
+    atomic_int readers[2]; // Readers in a read section, by epoch parity
+    PlayerSnapshot *retired; // Snapshots waiting for their readers
+    PlayerSnapshot *spare; // Reclaimed snapshots, sized for max players
+    Player *slots; // Preallocated players
+    Player **free_slots; // Stack of the free slots
+    int nb_free;
+    pthread_mutex_t write_mutex; // Serializes the writers only
 }PlayerList;
 
 /*
  * Creation and frees function on PLAYER
  */
 Player *create_player(PlayerList *players,int socket_fd);
-void free_player(Player *player);
 
 /*
  * Creation and frees function on PLAYER LIST
@@ -41,13 +109,20 @@ void free_player(Player *player);
 PlayerList* init_pl(int max_players);
 void free_player_list(PlayerList* players);
 void disconnect_allP(PlayerList* pl);
+void close_player_socket(Player *p);
 
 /*
  * Creation and frees function on PLAYER's CARDS
  */
-void init_player_card(PlayerList *pl, int nb_cards);
+void init_player_card(PlayerList *pl);
 void free_players_card(PlayerList *pl);
 
+/*
+ * Read sections on PLAYER LIST, a snapshot stays valid until release_players
+ */
+PlayerSnapshot *read_players(PlayerList *pl, int *slot);
+void release_players(PlayerList *pl, int slot);
+
 /*
  * Operations on PLAYER LIST
  */
@@ -59,7 +134,19 @@ int set_player_name(PlayerList *players, Player *p, char* name);
  * Message sending functions
  */
 int broadcast_message(PlayerList* players, Player* exclude_player, int params, const char* format, ...);
+int broadcast_raw(PlayerList* players, Player* exclude_player, int params, const char* msg, int length);
+int broadcast_styled(PlayerList* players, Player* exclude_player, int params, const char* msgs[MSG_STYLES], const int lengths[MSG_STYLES]);
+int broadcast_msg(PlayerList* players, Player* exclude_player, int params, int id, const MsgArg *args);
 void send_p(Player *player, const char* format, ...);
+void send_raw(Player *player, const char* msg, int length);
+void send_msg(Player *player, int id, const MsgArg *args);
+
+/*
+ * Output coalescing, a tick belongs to the thread that opened it
+ */
+void tick_begin(OutputTick *tick);
+void tick_flush(void);
+void tick_end(void);
 
 /*
  * Information getting function
@@ -0,0 +1,242 @@
+//
+// Created by erwan on 19/10/2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include "profiles.h"
+#include "memstats.h"
+
+#define PROFILE_MAGIC "TMPROF1"
+#define PROFILE_TABLE (PROFILE_MAX * 2) // Open addressing, kept half empty
+#define FLUSH_BATCH 64 // Records copied under the lock, then written without it
+
+/**
+ * @brief Header of the profile file, a file with another record layout is started again.
+ */
+typedef struct {
+    char magic[8];
+    uint32_t record_size;
+} ProfileHeader;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static int store_fd = -1; // Profile file, -1 if profiles are only kept in memory
+static Profile *profiles[PROFILE_MAX]; // In the order of the file records
+static int nb_profiles = 0;
+static int table[PROFILE_TABLE]; // Index in profiles + 1, 0 if empty
+static int dirty[PROFILE_MAX]; // Profiles changed since their last write
+static bool is_dirty[PROFILE_MAX];
+static int nb_dirty = 0;
+static pthread_t flusher;
+static bool flushing = false; // The flusher thread runs
+static pthread_cond_t flusher_cond = PTHREAD_COND_INITIALIZER; // Signaled to stop the flusher
+
+static uint32_t hash_name(const char *name) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *c = (const unsigned char *)name; *c; ++c) {
+        hash = (hash ^ *c) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Slot of a name in the table : the slot of its profile, or the empty slot where it goes.
+ */
+static int find_slot(const char *name) {
+    uint32_t i = hash_name(name) & (PROFILE_TABLE - 1);
+    while (table[i] != 0 && strcmp(profiles[table[i] - 1]->name, name) != 0) {
+        i = (i + 1) & (PROFILE_TABLE - 1);
+    }
+    return (int)i;
+}
+
+static Profile *insert(const Profile *record) {
+    if (nb_profiles == PROFILE_MAX) return NULL;
+    Profile *profile = mem_malloc(MEM_STATS, sizeof(Profile));
+    if (profile == NULL) {
+        perror("ERROR : profile allocation");
+        return NULL;
+    }
+    *profile = *record;
+    profiles[nb_profiles++] = profile;
+    table[find_slot(profile->name)] = nb_profiles;
+    return profile;
+}
+
+static off_t record_offset(int index) {
+    return (off_t)sizeof(ProfileHeader) + (off_t)index * (off_t)sizeof(Profile);
+}
+
+/**
+ * @brief Mark a profile to be written back by the flusher.
+ * @note Called with the lock held.
+ */
+static void mark_dirty(int index) {
+    if (store_fd < 0 || is_dirty[index]) return;
+    is_dirty[index] = true;
+    dirty[nb_dirty++] = index;
+}
+
+/**
+ * @brief Write back the changed profiles, the disk is only used without the lock.
+ * @note Called by the flusher, or once it stopped.
+ */
+static void flush_dirty(void) {
+    static Profile copies[FLUSH_BATCH];
+    static int indexes[FLUSH_BATCH];
+    while (1) {
+        pthread_mutex_lock(&lock);
+        int count = 0;
+        while (nb_dirty > 0 && count < FLUSH_BATCH) {
+            int index = dirty[--nb_dirty];
+            is_dirty[index] = false;
+            indexes[count] = index;
+            copies[count++] = *profiles[index];
+        }
+        pthread_mutex_unlock(&lock);
+        if (count == 0) return;
+
+        for (int i = 0; i < count; ++i) {
+            if (pwrite(store_fd, &copies[i], sizeof(Profile), record_offset(indexes[i])) != (ssize_t)sizeof(Profile)) {
+                perror("Erreur lors de l'écriture du profil");
+            }
+        }
+    }
+}
+
+static void *run_flusher(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&lock);
+    while (flushing) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += PROFILE_FLUSH_MS / 1000;
+        deadline.tv_nsec += (PROFILE_FLUSH_MS % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&flusher_cond, &lock, &deadline);
+        pthread_mutex_unlock(&lock);
+        flush_dirty();
+        pthread_mutex_lock(&lock);
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+/**
+ * @brief Load the profiles of a file, it is created if needed, and start their write back.
+ *
+ * A file with another record layout is emptied. If the flusher can't start, the profiles are written at the close.
+ *
+ * @return 0 on success, -1 if the file can't be used : the profiles are then only kept in memory.
+ */
+int profiles_open(const char *path) {
+    int fd = open(path, O_RDWR | O_CREAT, 0666);
+    if (fd == -1) {
+        perror("Erreur lors de l'ouverture du fichier des profils");
+        return -1;
+    }
+    ProfileHeader header;
+    ssize_t n = pread(fd, &header, sizeof(header), 0);
+    if (n != (ssize_t)sizeof(header) || memcmp(header.magic, PROFILE_MAGIC, sizeof(PROFILE_MAGIC)) != 0
+        || header.record_size != sizeof(Profile)) {
+        if (n > 0) fprintf(stderr, "Fichier des profils %s d'un autre format, il est remis à zéro\n", path);
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, PROFILE_MAGIC, sizeof(PROFILE_MAGIC));
+        header.record_size = sizeof(Profile);
+        if (ftruncate(fd, 0) == -1 || pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+            perror("Erreur lors de l'écriture du fichier des profils");
+            close(fd);
+            return -1;
+        }
+    }
+
+    pthread_mutex_lock(&lock);
+    Profile record;
+    while (pread(fd, &record, sizeof(record), record_offset(nb_profiles)) == (ssize_t)sizeof(record)) {
+        record.name[PROFILE_NAME_SIZE - 1] = '\0';
+        if (insert(&record) == NULL) break;
+    }
+    store_fd = fd;
+    flushing = pthread_create(&flusher, NULL, run_flusher, NULL) == 0;
+    if (!flushing) perror("ERROR creating profile flusher thread");
+    pthread_mutex_unlock(&lock);
+    return 0;
+}
+
+/**
+ * @brief Write back the changed profiles, close the profile file and free the profiles.
+ */
+void profiles_close(void) {
+    pthread_mutex_lock(&lock);
+    bool running = flushing;
+    flushing = false;
+    pthread_cond_signal(&flusher_cond);
+    pthread_mutex_unlock(&lock);
+    if (running) pthread_join(flusher, NULL);
+    flush_dirty();
+
+    pthread_mutex_lock(&lock);
+    if (store_fd >= 0) close(store_fd);
+    store_fd = -1;
+    for (int i = 0; i < nb_profiles; ++i) {
+        mem_free(MEM_STATS, profiles[i]);
+    }
+    nb_profiles = 0;
+    memset(table, 0, sizeof(table));
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * @brief Add a round to the profile of a player, created on its first round, written back later by the flusher.
+ * @param level Level of the round.
+ * @param lost_card The player played the card that lost the round.
+ * @param reaction Reaction times of the player in the round.
+ */
+void profile_add_round(const char *name, int level, bool win, bool lost_card, const Histogram *reaction) {
+    pthread_mutex_lock(&lock);
+    int index = table[find_slot(name)] - 1;
+    if (index < 0) {
+        Profile record;
+        memset(&record, 0, sizeof(record));
+        snprintf(record.name, sizeof(record.name), "%s", name);
+        if (insert(&record) == NULL) { // Full
+            pthread_mutex_unlock(&lock);
+            return;
+        }
+        index = nb_profiles - 1;
+    }
+    Profile *profile = profiles[index];
+    profile->rounds++;
+    if (win) {
+        profile->win_rounds++;
+        if ((uint32_t)level > profile->best_level) profile->best_level = level;
+    }
+    profile->cards += reaction->total;
+    if (lost_card) profile->losing_cards++;
+    hist_merge(&profile->reaction, reaction);
+    mark_dirty(index);
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * @brief Copy the profile of a player.
+ * @return 0 on success, -1 if the player has no profile.
+ */
+int profile_get(const char *name, Profile *out) {
+    pthread_mutex_lock(&lock);
+    int slot = find_slot(name);
+    if (table[slot] == 0) {
+        pthread_mutex_unlock(&lock);
+        return -1;
+    }
+    *out = *profiles[table[slot] - 1];
+    pthread_mutex_unlock(&lock);
+    return 0;
+}
@@ -0,0 +1,39 @@
+//
+// Created by erwan on 19/10/2026.
+//
+
+#ifndef THEMIND_PROFILES_H
+#define THEMIND_PROFILES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "histogram.h"
+#include "statsManager.h"
+
+#define PROFILE_FILE DATA_DIR"/profiles.dat"
+#define PROFILE_MAX 4096 // Profiles of the server, new names get none once full
+#define PROFILE_NAME_SIZE 50
+#define PROFILE_FLUSH_MS 1000 // Period of the write back of the changed profiles
+
+/**
+ * @brief Results of a player over all its games, kept by name.
+ *
+ * Profiles are stored as fixed size records : an update rewrites only the record of the player.
+ * Records are written back by a background thread, never by the tables.
+ */
+typedef struct {
+    char name[PROFILE_NAME_SIZE];
+    uint32_t rounds;
+    uint32_t win_rounds;
+    uint32_t best_level; // Highest level won
+    uint32_t cards; // Cards played
+    uint32_t losing_cards; // Cards that lost a round
+    Histogram reaction; // Reaction times, in ns
+} Profile;
+
+int profiles_open(const char *path);
+void profiles_close(void);
+void profile_add_round(const char *name, int level, bool win, bool lost_card, const Histogram *reaction);
+int profile_get(const char *name, Profile *out);
+
+#endif //THEMIND_PROFILES_H
@@ -3,64 +3,52 @@
 //
 
 #include "queue.h"
+#include "memstats.h"
 #include <stdio.h>
 #include <stdlib.h>
 
 // Crée une nouvelle file vide
 Queue* create_queue() {
-    Queue* queue = (Queue*)malloc(sizeof(Queue));
+    Queue* queue = mem_malloc(MEM_QUEUE,sizeof(Queue));
     if (!queue) {
         perror("Erreur d'allocation mémoire");
         exit(EXIT_FAILURE);
     }
-    queue->front = queue->rear = NULL;
+    reset_queue(queue);
     return queue;
 }
 
-// Ajoute un élément à la file
+// Ajoute une carte, la file reste triée
 void enqueue(Queue* queue, int value) {
-    Node* newNode = (Node*)malloc(sizeof(Node));
-    if (!newNode) {
-        perror("Erreur d'allocation mémoire");
-        exit(EXIT_FAILURE);
-    }
-    newNode->data = value;
-    newNode->next = NULL;
-
-    if (queue->rear == NULL) {
-        // La file est vide
-        queue->front = queue->rear = newNode;
-    } else {
-        queue->rear->next = newNode;
-        queue->rear = newNode;
+    if (value < 0 || value > QUEUE_MAX_CARD) {
+        fprintf(stderr, "Erreur : carte %d hors de la file\n", value);
+        return;
     }
+    queue->bits[value >> 6] |= (uint64_t)1 << (value & 63);
 }
 
-// Retire un élément de la file
+// Retire la plus petite carte
 int dequeue(Queue* queue) {
-    if (queue->front == NULL) {
-//        fprintf(stderr, "La file est vide\n");
-        return -1; // Erreur
-    }
-
-    Node* temp = queue->front;
-    int value = temp->data;
-    queue->front = queue->front->next;
-
-    if (queue->front == NULL) {
-        queue->rear = NULL; // La file est maintenant vide
-    }
-
-    free(temp);
+    int value = peek(queue);
+    if (value == -1) return -1; // Erreur
+    queue->bits[value >> 6] &= queue->bits[value >> 6] - 1; // Bit le plus bas
     return value;
 }
 
-// Regarde l'élément en tête sans le retirer
+// Retire une carte donnée, -1 si elle n'est pas dans la file
+int queue_remove(Queue* queue, int value) {
+    if (value < 0 || value > QUEUE_MAX_CARD) return -1;
+    uint64_t bit = (uint64_t)1 << (value & 63);
+    if (!(queue->bits[value >> 6] & bit)) return -1;
+    queue->bits[value >> 6] &= ~bit;
+    return 0;
+}
+
+// Regarde la plus petite carte sans la retirer
 int peek(Queue* queue) {
-    if (queue->front == NULL) {
-        return -1;
-    }
-    return queue->front->data;
+    if (queue->bits[0]) return __builtin_ctzll(queue->bits[0]);
+    if (queue->bits[1]) return 64 + __builtin_ctzll(queue->bits[1]);
+    return -1;
 }
 
 void reset_queue(Queue* queue) {
@@ -68,78 +56,16 @@ void reset_queue(Queue* queue) {
         fprintf(stderr, "Erreur : file inexistante\n");
         return;
     }
-
-    // Libérer tous les noeuds de la file
-    while (queue->front != NULL) {
-        Node* temp = queue->front;
-        queue->front = queue->front->next;
-        free(temp);
-    }
-
-    // Réinitialiser les pointeurs
-    queue->front = NULL;
-    queue->rear = NULL;
-}
-
-void sort_queue(Queue* queue) {
-    if (!queue || isEmpty(queue)) {
-        fprintf(stderr, "Erreur : File inexistante ou vide\n");
-        return;
-    }
-
-    // Compter les éléments et les stocker dans un tableau dynamique
-    int count = 0;
-    Node* current = queue->front;
-    while (current) {
-        count++;
-        current = current->next;
-    }
-
-    int* elements = (int*)malloc(count * sizeof(int));
-    if (!elements) {
-        perror("Erreur d'allocation mémoire pour le tri");
-        exit(EXIT_FAILURE);
-    }
-
-    // Transférer les éléments de la file dans le tableau
-    current = queue->front;
-    for (int i = 0; i < count; i++) {
-        elements[i] = current->data;
-        current = current->next;
-    }
-
-    // Trier le tableau
-    for (int i = 0; i < count - 1; i++) {
-        for (int j = i + 1; j < count; j++) {
-            if (elements[i] > elements[j]) {
-                // Échanger les valeurs
-                int temp = elements[i];
-                elements[i] = elements[j];
-                elements[j] = temp;
-            }
-        }
-    }
-
-    // Réinitialiser la file et insérer les éléments triés
-    reset_queue(queue);
-    for (int i = 0; i < count; i++) {
-        enqueue(queue, elements[i]);
-    }
-
-    // Libérer la mémoire du tableau
-    free(elements);
+    queue->bits[0] = 0;
+    queue->bits[1] = 0;
 }
 
 // Vérifie si la file est vide
 int isEmpty(Queue* queue) {
-    return queue->front == NULL;
+    return (queue->bits[0] | queue->bits[1]) == 0;
 }
 
-// Libère toute la mémoire utilisée par la file
+// Libère la file
 void destroy_queue(Queue* queue) {
-    while (!isEmpty(queue)) {
-        dequeue(queue);
-    }
-    free(queue);
+    mem_free(MEM_QUEUE,queue);
 }
-
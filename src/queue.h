@@ -5,25 +5,26 @@
 #ifndef THEMIND_QUEUE_H
 #define THEMIND_QUEUE_H
 
-// Définition d'un élément de la file
-typedef struct Node {
-    int data;
-    struct Node* next;
-} Node;
+#include <stdint.h>
 
-// Définition de la file
+#define QUEUE_MAX_CARD 127 // Plus grande carte représentable
+
+/**
+ * @brief Ensemble de cartes (1 à 99), toujours trié : le bit n est levé si la carte n est présente.
+ *
+ * Insertion, minimum et retrait du minimum se font en temps constant, sans allocation.
+ */
 typedef struct Queue {
-    Node* front; // Tête de la file
-    Node* rear;  // Fin de la file
+    uint64_t bits[2];
 } Queue;
 
 Queue* create_queue();
 void enqueue(Queue* queue, int value);
 int dequeue(Queue* queue);
 int peek(Queue* queue);
+int queue_remove(Queue* queue, int value);
 int isEmpty(Queue* queue);
 void destroy_queue(Queue* queue);
 void reset_queue(Queue* queue);
-void sort_queue(Queue* queue);
 
 #endif //THEMIND_QUEUE_H
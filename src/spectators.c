@@ -0,0 +1,178 @@
+//
+// Created by erwan on 19/10/2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "spectators.h"
+#include "memstats.h"
+
+/**
+ * @brief Remove the viewers whose write failed and close their socket.
+ */
+static void drop_viewers(Spectators *s, const int *dropped, int nb_dropped) {
+    pthread_mutex_lock(&s->mutex);
+    for (int d = 0; d < nb_dropped; ++d) {
+        for (int i = 0; i < s->count; ++i) {
+            if (s->fds[i] == dropped[d]) {
+                s->fds[i] = s->fds[--s->count];
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&s->mutex);
+    for (int d = 0; d < nb_dropped; ++d) {
+        close(dropped[d]);
+    }
+}
+
+/**
+ * @brief Fan-out thread, sends the published events to every viewer.
+ *
+ * Events and the viewers list are copied under the mutex, the writes are done without it.
+ * Each viewer gets the pending events in one writev.
+ */
+static void *fan_out(void *arg) {
+    Spectators *s = arg;
+    SpectatorEvent batch[SPECTATOR_BATCH];
+    struct iovec iov[SPECTATOR_BATCH];
+    int fds[MAX_SPECTATORS];
+    int dropped[MAX_SPECTATORS];
+
+    while (1) {
+        pthread_mutex_lock(&s->mutex);
+        while (s->running && s->tail == s->head) {
+            pthread_cond_wait(&s->cond, &s->mutex);
+        }
+        if (!s->running) {
+            pthread_mutex_unlock(&s->mutex);
+            break;
+        }
+        if (s->head - s->tail > SPECTATOR_RING) { // The publisher went round the ring
+            s->lost += s->head - s->tail - SPECTATOR_RING;
+            s->tail = s->head - SPECTATOR_RING;
+        }
+        int nb_events = 0;
+        size_t total = 0;
+        while (s->tail != s->head && nb_events < SPECTATOR_BATCH) {
+            SpectatorEvent *ev = &s->ring[s->tail % SPECTATOR_RING];
+            memcpy(batch[nb_events].data, ev->data, ev->len);
+            batch[nb_events].len = ev->len;
+            iov[nb_events].iov_base = batch[nb_events].data;
+            iov[nb_events].iov_len = ev->len;
+            total += ev->len;
+            nb_events++;
+            s->tail++;
+        }
+        int count = s->count;
+        memcpy(fds, s->fds, count * sizeof(int));
+        pthread_mutex_unlock(&s->mutex);
+
+        int nb_dropped = 0;
+        for (int i = 0; i < count; ++i) {
+            ssize_t written = writev(fds[i], iov, nb_events);
+            if (written != (ssize_t)total) { // Closed, or too slow to take the batch
+                dropped[nb_dropped++] = fds[i];
+            }
+        }
+        if (nb_dropped > 0) {
+            drop_viewers(s, dropped, nb_dropped);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Create the viewers of a table and start its fan-out thread.
+ * @return The spectators structure, or NULL on error.
+ */
+Spectators *create_spectators(void) {
+    Spectators *s = mem_malloc(MEM_NETWORK, sizeof(Spectators));
+    if (s == NULL) return NULL;
+    s->count = 0;
+    s->head = 0;
+    s->tail = 0;
+    s->lost = 0;
+    s->running = true;
+    pthread_mutex_init(&s->mutex, NULL);
+    pthread_cond_init(&s->cond, NULL);
+    if (pthread_create(&s->thread, NULL, fan_out, s) != 0) {
+        perror("ERROR creating spectators thread");
+        pthread_mutex_destroy(&s->mutex);
+        pthread_cond_destroy(&s->cond);
+        mem_free(MEM_NETWORK, s);
+        return NULL;
+    }
+    return s;
+}
+
+/**
+ * @brief Stop the fan-out thread, disconnect every viewer and free the structure.
+ */
+void free_spectators(Spectators *s) {
+    if (s == NULL) return;
+    pthread_mutex_lock(&s->mutex);
+    s->running = false;
+    pthread_cond_signal(&s->cond);
+    pthread_mutex_unlock(&s->mutex);
+    pthread_join(s->thread, NULL);
+
+    for (int i = 0; i < s->count; ++i) {
+        close(s->fds[i]);
+    }
+    pthread_mutex_destroy(&s->mutex);
+    pthread_cond_destroy(&s->cond);
+    mem_free(MEM_NETWORK, s);
+}
+
+/**
+ * @brief Attach a viewer, the socket is switched to nonblocking and owned by the structure.
+ * @return 0 on success, -1 if the table has too many viewers.
+ */
+int add_spectator(Spectators *s, int socket_fd) {
+    pthread_mutex_lock(&s->mutex);
+    if (s->count >= MAX_SPECTATORS) {
+        pthread_mutex_unlock(&s->mutex);
+        return -1;
+    }
+    fcntl(socket_fd, F_SETFL, fcntl(socket_fd, F_GETFL) | O_NONBLOCK);
+    s->fds[s->count++] = socket_fd;
+    pthread_mutex_unlock(&s->mutex);
+    return 0;
+}
+
+int spectators_count(Spectators *s) {
+    pthread_mutex_lock(&s->mutex);
+    int count = s->count;
+    pthread_mutex_unlock(&s->mutex);
+    return count;
+}
+
+/**
+ * @brief Publish an event to the viewers.
+ *
+ * The message is copied once in the ring, the caller never waits for a viewer.
+ * Nothing is copied when the table has no viewer.
+ *
+ * @param msg Encoded message, as sent to the players.
+ * @param len Length of the message.
+ */
+void spectators_publish(Spectators *s, const char *msg, int len) {
+    if (s == NULL || len <= 0) return;
+    if (len > SPECTATOR_EVENT_SIZE) len = SPECTATOR_EVENT_SIZE;
+
+    pthread_mutex_lock(&s->mutex);
+    if (s->count == 0) {
+        pthread_mutex_unlock(&s->mutex);
+        return;
+    }
+    SpectatorEvent *ev = &s->ring[s->head % SPECTATOR_RING];
+    memcpy(ev->data, msg, len);
+    ev->len = len;
+    s->head++;
+    pthread_cond_signal(&s->cond);
+    pthread_mutex_unlock(&s->mutex);
+}
@@ -0,0 +1,52 @@
+//
+// Created by erwan on 19/10/2026.
+//
+
+#ifndef THEMIND_SPECTATORS_H
+#define THEMIND_SPECTATORS_H
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#define MAX_SPECTATORS 512 // Viewers per table
+#define SPECTATOR_RING 128 // Events kept for the fan-out thread, older ones are overwritten
+#define SPECTATOR_EVENT_SIZE 1024 // Longer events are truncated
+#define SPECTATOR_BATCH 16 // Events sent to a viewer in one writev
+
+/**
+ * @brief Public event encoded once, shared by every viewer.
+ */
+typedef struct {
+    int len;
+    char data[SPECTATOR_EVENT_SIZE];
+} SpectatorEvent;
+
+/**
+ * @struct Spectators
+ * @brief Read-only viewers of a table.
+ *
+ * The game publishes public events (plays, board, round results) in a ring, with a copy under a
+ * short mutex. A fan-out thread sends them to every viewer with nonblocking writes: a viewer whose
+ * socket can't take the whole batch is too slow and gets disconnected, so it never delays the table.
+ */
+typedef struct {
+    int fds[MAX_SPECTATORS]; // Viewers sockets
+    int count; // Number of viewers
+    SpectatorEvent ring[SPECTATOR_RING];
+    unsigned long head; // Sequence number of the next published event
+    unsigned long tail; // Sequence number of the next event to send
+    unsigned long lost; // Events overwritten before being sent
+    bool running;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_t thread;
+} Spectators;
+
+Spectators *create_spectators(void);
+void free_spectators(Spectators *s);
+
+int add_spectator(Spectators *s, int socket_fd);
+int spectators_count(Spectators *s);
+void spectators_publish(Spectators *s, const char *msg, int len);
+
+#endif //THEMIND_SPECTATORS_H
@@ -3,19 +3,28 @@
 //
 
 #include <stdio.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include "statsManager.h"
+#include "trace.h"
+#include "memstats.h"
+#include "analytics.h"
 
 /**
  * @brief Creates and initializes a new GameData structure.
  *
+ * The rounds are streamed to the data file during the game, only the summary stays in memory.
+ * The data file is created by the first write, a game without any round leaves no file.
+ *
  * @return Pointer to the newly allocated GameData structure, or NULL if memory allocation fails.
  */
 GameData *create_gm() {
-    GameData *gm = malloc(sizeof (GameData));
+    GameData *gm = mem_malloc(MEM_STATS,sizeof (GameData));
     if(!gm){
         fprintf(stderr,"Erreur : impossible d'allouer la mémoire pour GameData\n");
         return NULL;
@@ -26,10 +35,13 @@ GameData *create_gm() {
     gm->max_round_lvl = 0;
     for (int i = 0; i < 100; i++) {
         gm->loosing_cards[i] = 0;
-        gm->avg_reaction_time[i] = 0.0;
+        hist_reset(&gm->reaction[i]);
         gm->cards[i] = 0;
     }
-    gm->round_list = NULL;
+    gm->nb_chunk = 0;
+    gm->written = false;
+    gm->lost = false;
+    gm->data_fp[0] = '\0';
 
     return gm;
 }
@@ -37,60 +49,113 @@ GameData *create_gm() {
 /**
  * @brief Frees the memory allocated for a GameData structure.
  *
+ * The data file of a game that was never fully written (server stopped during the game) is removed.
+ *
  * @param gm Pointer to the GameData structure to be freed.
  */
 void free_gm(GameData *gm) {
     if(gm){
-        free(gm->round_list);
-        free(gm);
+        if(!gm->written && gm->data_fp[0] != '\0') unlink(gm->data_fp);
+        mem_free(MEM_STATS,gm);
     }
 }
 
 /**
- * @brief Create FILE to store datas.
+ * @brief Create FILE to store datas, it starts with the list of the rounds.
+ *
+ * Tables may end their games in the same second : a suffix is added to the date if the file exists.
+ *
  * @param gm The Game Data struct associate.
- * @return A pointer to the data_fp.
+ * @return A pointer to the data_fp, or NULL on error.
  */
 char *create_uf(GameData *gm) {
     time_t now = time(NULL);
     struct tm *local = localtime(&now);
     char date[20]; // YYYY-MM-DD + '\0'
     strftime(date, sizeof(date), "%Y-%m-%d-%H_%M_%S", local);
-    char path[30]; // ../datas/ + date + '\0'
-    snprintf(path, sizeof(path), DATA_DIR"/%s", date);
-
-    FILE *file = fopen(path,"w");
+    char path[sizeof(gm->data_fp)];
+
+    int fd = -1;
+    for (int i = 0; fd == -1 && i < 100; i++) {
+        if (i == 0) {
+            snprintf(path, sizeof(path), DATA_DIR"/%s", date);
+        } else {
+            snprintf(path, sizeof(path), DATA_DIR"/%s-%d", date, i);
+        }
+        fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0666);
+        if (fd == -1 && errno != EEXIST) break;
+    }
+    if (fd == -1) {
+        perror("Erreur lors de la création du fichier ");
+        return NULL;
+    }
+    FILE *file = fdopen(fd,"w");
     if (!file) {
         perror("Erreur lors de la création du fichier ");
+        close(fd);
+        unlink(path);
         return NULL;
     }
+    fprintf(file, "ROUNDSLIST"); // Continued by add_round, ended by write_data_to_file
     fclose(file);
 
     if(chmod(path,0777) !=0){
         perror("Erreur lors de la definition des permissions du fichier");
-        return NULL;
     }
 
-    strncpy(gm->data_fp,path,sizeof(path));
+    snprintf(gm->data_fp,sizeof(gm->data_fp),"%s",path);
     return gm->data_fp;
 }
 
 /**
- * @brief Adds a card play to the GameData structure and updates the reaction time for the card.
+ * @brief Open the data file for appending, it is created by the first call.
+ * @return The file, or NULL on error.
+ */
+static FILE *open_data_file(GameData *gm) {
+    if (gm->data_fp[0] == '\0' && create_uf(gm) == NULL) return NULL;
+    FILE *file = fopen(gm->data_fp,"a");
+    if (!file) {
+        fprintf(stderr, "Erreur lors de l'ouverture du fichier de stats\n");
+    }
+    return file;
+}
+
+/**
+ * @brief Append the rounds kept in memory to the data file.
+ * @return 0 on success, -1 if the file can't be written : the rounds are lost.
+ */
+static int flush_rounds(GameData *gm) {
+    if (gm->nb_chunk == 0) return 0;
+    TRACE_BEGIN(span);
+    FILE *file = open_data_file(gm);
+    if (!file) {
+        fprintf(stderr, "Erreur : %d manche(s) perdue(s) pour les statistiques\n", gm->nb_chunk);
+        gm->nb_chunk = 0;
+        gm->lost = true;
+        TRACE_END(span,"stats:flush_rounds");
+        return -1;
+    }
+    for (int i = 0; i < gm->nb_chunk; i++) {
+        fprintf(file, " %d", gm->round_chunk[i]);
+    }
+    fclose(file);
+    gm->nb_chunk = 0;
+    TRACE_END(span,"stats:flush_rounds");
+    return 0;
+}
+
+/**
+ * @brief Adds a card play to the GameData structure and records the reaction time for the card.
  *
  * @param gm Pointer to the GameData structure.
  * @param card The card ID to be added.
- * @param reaction_time The reaction time in milliseconds.
+ * @param reaction_ns The reaction time in nanoseconds.
  */
-void add_card(GameData *gm, int card, time_t reaction_time) {
+void add_card(GameData *gm, int card, uint64_t reaction_ns) {
     // Incrémente le nombre de fois que la carte a été jouée
     gm->cards[card]++;
-    int nbc = gm->cards[card]; // Nouveau nombre de cartes jouées
-    double avgt = gm->avg_reaction_time[card]; // Ancien temps moyen
-
-    // Recalcule le nouveau temps de réaction moyen
-    gm->avg_reaction_time[card] = (nbc - 1) * avgt + (int)reaction_time;
-    gm->avg_reaction_time[card] /= nbc;
+    hist_record(&gm->reaction[card], reaction_ns);
+    analytics_card(card);
 }
 
 /**
@@ -102,13 +167,8 @@ void add_card(GameData *gm, int card, time_t reaction_time) {
  */
 void add_round(GameData *gm, int round_lvl, int win) {
     if(!gm) return;
-    int *new_list = realloc(gm->round_list, (gm->rounds + 1) * sizeof(int));
-    if(!new_list) {
-        fprintf(stderr,"Erreur impossible d'allouer la mémoire pour round_list\n");
-        return;
-    }
-    gm->round_list = new_list;
-    gm->round_list[gm->rounds] = round_lvl;
+    if(gm->nb_chunk == ROUND_CHUNK) flush_rounds(gm);
+    gm->round_chunk[gm->nb_chunk++] = round_lvl;
 
     gm->rounds++;
     if(win) {
@@ -119,24 +179,40 @@ void add_round(GameData *gm, int round_lvl, int win) {
 }
 
 /**
- * @brief Records a losing card and updates its reaction time statistics.
+ * @brief Records a losing card and its reaction time.
  *
  * @param gm Pointer to the GameData structure.
  * @param card The ID of the losing card.
- * @param reaction_time The reaction time in milliseconds.
+ * @param reaction_ns The reaction time in nanoseconds.
  */
-void add_loosing_card(GameData *gm, int card, time_t reaction_time){
+void add_loosing_card(GameData *gm, int card, uint64_t reaction_ns){
     gm->loosing_cards[card]++;
-    add_card(gm,card,reaction_time);
+    add_card(gm,card,reaction_ns);
+    analytics_losing_card(card);
 }
 
-int write_data_to_file(GameData *gm) {
-    FILE *file = fopen(gm->data_fp,"w");
+#define NS_TO_S(ns) ((double)(ns) / 1e9)
 
-    if (!file) {
-        fprintf(stderr, "Erreur lors de l'ouverture du fichier de stats\n");
-        return -1;
+static void write_percentile_line(FILE *file, const char *key, const Histogram *hists, double percent) {
+    fprintf(file, "%s", key);
+    for (int i = 0; i < 100; i++) {
+        fprintf(file, " %.3f", NS_TO_S(hist_percentile(&hists[i], percent)));
     }
+    fprintf(file, "\n");
+}
+
+/**
+ * @brief Complete the data file : the last rounds, then the summary of the game.
+ *
+ * The rounds already streamed are not rewritten, so the cost doesn't depend on the length of the game.
+ *
+ * @return 0 on success, -1 on error.
+ */
+int write_data_to_file(GameData *gm) {
+    if (flush_rounds(gm) == -1 || gm->lost) return -1;
+    FILE *file = open_data_file(gm);
+    if (!file) return -1;
+    fprintf(file, "\n"); // Fin de la liste des rounds
 
     // Ligne pour le nombre de joueurs
     fprintf(file, "PLAYER %d\n", gm->player_count);
@@ -157,29 +233,29 @@ int write_data_to_file(GameData *gm) {
     }
     fprintf(file, "\n");
 
-    // Ligne pour le temps de réaction moyen global
-    double total_reaction_time = 0;
-    int total_cards_played = 0;
+    // Ligne pour le temps de réaction moyen global, en secondes
+    Histogram all;
+    hist_reset(&all);
     for (int i = 0; i < 100; i++) {
-        total_reaction_time += gm->avg_reaction_time[i] * gm->cards[i];
-        total_cards_played += gm->cards[i];
+        hist_merge(&all, &gm->reaction[i]);
     }
-    double avg_reaction_time = total_cards_played > 0 ? total_reaction_time / total_cards_played : 0;
-    fprintf(file, "REACTIONTIME %.2f\n", avg_reaction_time);
+    fprintf(file, "REACTIONTIME %.2f\n", NS_TO_S(hist_mean(&all)));
+
+    // Percentiles p50 p90 p99 de toute la partie
+    fprintf(file, "REACTIONPERCENTILES %.3f %.3f %.3f\n", NS_TO_S(hist_percentile(&all, 50)),
+            NS_TO_S(hist_percentile(&all, 90)), NS_TO_S(hist_percentile(&all, 99)));
 
     // Ligne pour le temps de réaction moyen par carte
     fprintf(file, "REACTIONPERCARD");
     for (int i = 0; i < 100; i++) {
-        fprintf(file, " %.2f", gm->avg_reaction_time[i]);
+        fprintf(file, " %.2f", NS_TO_S(hist_mean(&gm->reaction[i])));
     }
     fprintf(file, "\n");
 
-    // Ligne pour la liste des rounds joués
-    fprintf(file, "ROUNDSLIST");
-    for (int i = 0; i < gm->rounds; i++) {
-        fprintf(file, " %d", gm->round_list[i]);
-    }
-    fprintf(file, "\n");
+    // Percentiles par carte
+    write_percentile_line(file, "REACTIONP50CARD", gm->reaction, 50);
+    write_percentile_line(file, "REACTIONP90CARD", gm->reaction, 90);
+    write_percentile_line(file, "REACTIONP99CARD", gm->reaction, 99);
 
     // Ligne pour le nombre de fois où chaque carte a été jouée
     fprintf(file, "CARDSPLAYED");
@@ -188,6 +264,25 @@ int write_data_to_file(GameData *gm) {
     }
     fprintf(file, "\n");
 
+    fclose(file);
+    gm->written = true;
+    return 0;
+}
+
+/**
+ * @brief Append the reaction times of a player to the data file : cards played, p50, p90 and p99 in seconds.
+ * @note Called after write_data_to_file, once per player.
+ * @return 0 on success, -1 on error.
+ */
+int write_player_reaction(GameData *gm, const char *name, const Histogram *h) {
+    if (gm->data_fp[0] == '\0') return -1;
+    FILE *file = fopen(gm->data_fp,"a");
+    if (!file) {
+        fprintf(stderr, "Erreur lors de l'ouverture du fichier de stats\n");
+        return -1;
+    }
+    fprintf(file, "REACTIONPLAYER %s %llu %.3f %.3f %.3f\n", name, (unsigned long long)h->total,
+            NS_TO_S(hist_percentile(h, 50)), NS_TO_S(hist_percentile(h, 90)), NS_TO_S(hist_percentile(h, 99)));
     fclose(file);
     return 0;
 }
@@ -202,7 +297,9 @@ int make_dg(const char* datas_fp){
     char cmd[512];
     int ret;
     snprintf(cmd,sizeof(cmd), "./scripts/make_dg.sh %s",datas_fp);
+    TRACE_BEGIN(span);
     ret = system(cmd);
+    TRACE_END(span,"system:make_dg");
     if (ret == -1) {
         perror("Erreur lors de l'exécution de la commande");
         return -1;  // Indique une erreur d'exécution
@@ -230,7 +327,9 @@ int make_pdf(const char *data_fp) {
     char latex_f[] = "./ressources/main.tex";
     int ret;
     snprintf(cmd,sizeof(cmd),"./scripts/make_pdf.sh %s %s",data_fp,latex_f);
+    TRACE_BEGIN(span);
     ret = system(cmd);
+    TRACE_END(span,"system:make_pdf");
     if(ret == -1) {
         perror("Erreur lors de l'éxécution de la commande");
         return -1;
@@ -250,28 +349,29 @@ int make_pdf(const char *data_fp) {
  * @brief add a game in the rank.dat file
  * @param gm The game data
  * @param p_names All the players name in this game
+ * @param nb_names Number of names, players may have left since the start of the game
  *
  * @warning this function need the script add_rank.sh.
  * @return 0 if it was succes, -1 if errrors occurs
  */
-int write_game_rank(GameData* gm, char **p_names){
+int write_game_rank(GameData* gm, char **p_names, int nb_names){
 
     // Format players name
     size_t pnt = 1;
-    for (int i = 0; i < gm->player_count; i++) {
+    for (int i = 0; i < nb_names; i++) {
         pnt += strlen(p_names[i]) + 1;
     }
 
-    char *format_pn = malloc(pnt);
+    char *format_pn = mem_malloc(MEM_STATS,pnt);
     if(format_pn == NULL){
         perror("ERROR : Memory allocation");
         return -1;
     }
 
     format_pn[0] = '\0';
-    for (int i = 0; i < gm->player_count; i++) {
+    for (int i = 0; i < nb_names; i++) {
         strcat(format_pn,p_names[i]);
-        if(i < gm->player_count - 1){
+        if(i < nb_names - 1){
             strcat(format_pn, " ");
         }
     }
@@ -279,9 +379,11 @@ int write_game_rank(GameData* gm, char **p_names){
     char cmd[BUFSIZ];
     int ret;
     snprintf(cmd,sizeof(cmd),"./scripts/add_rank.sh %d %d %s",gm->player_count,gm->max_round_lvl,format_pn);
+    TRACE_BEGIN(span);
     ret = system(cmd);
+    TRACE_END(span,"system:add_rank");
 
-    free(format_pn);
+    mem_free(MEM_STATS,format_pn);
 
     if(ret == -1) {
         perror("Erreur lors de l'éxécution de la commande");
@@ -312,6 +414,7 @@ char** get_top10(int nb_p, int *line_count) {
     snprintf(cmd, sizeof(cmd), "./scripts/top10.sh %d", nb_p);
 
     // Ouvrir le processus pour lire la sortie du script
+    TRACE_BEGIN(span);
     FILE *fp = popen(cmd, "r");
     if (fp == NULL) {
         perror("Erreur lors de l'exécution du script");
@@ -324,14 +427,14 @@ char** get_top10(int nb_p, int *line_count) {
     *line_count = 0;
 
     while (fgets(buffer, sizeof(buffer), fp) != NULL) {
-        lines = realloc(lines, (*line_count + 1) * sizeof(char*));
+        lines = mem_realloc(MEM_STATS,lines, (*line_count + 1) * sizeof(char*));
         if (lines == NULL) {
             perror("Erreur lors du réallouage de mémoire");
             pclose(fp);
             return NULL;
         }
         buffer[strcspn(buffer, "\n")] = '\0'; // Retirer le '\n'
-        lines[*line_count] = strdup(buffer);
+        lines[*line_count] = mem_strdup(MEM_STATS,buffer);
         if (lines[*line_count] == NULL) {
             perror("Erreur lors de la duplication de la ligne");
             pclose(fp);
@@ -341,12 +444,14 @@ char** get_top10(int nb_p, int *line_count) {
     }
 
     // Fermer le flux
-    if (pclose(fp) == -1) {
+    int closed = pclose(fp);
+    TRACE_END(span,"popen:top10");
+    if (closed == -1) {
         perror("Erreur lors de la fermeture du processus");
         for (int i = 0; i < *line_count; i++) {
-            free(lines[i]);
+            mem_free(MEM_STATS,lines[i]);
         }
-        free(lines);
+        mem_free(MEM_STATS,lines);
         return NULL;
     }
 
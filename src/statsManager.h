@@ -6,8 +6,12 @@
 #define TEST_STATMANAGERV_H
 
 #include <bits/types/FILE.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "histogram.h"
 
 #define DATA_DIR "./datas"
+#define ROUND_CHUNK 256 // Rounds kept in memory before being appended to the data file
 
 /**
  * @warning Before use this module ensure that the project have the correct file and directory structure,
@@ -20,22 +24,26 @@ typedef struct {
     int win_rounds;
     int max_round_lvl;
     int loosing_cards[100];
-    double avg_reaction_time[100];
+    Histogram reaction[100]; // Reaction times of each card, in ns
     int cards[100];
-    int *round_list;
-    char data_fp[30];
+    int round_chunk[ROUND_CHUNK]; // Levels of the last rounds, not yet in the data file
+    int nb_chunk;
+    bool written; // The summary is in the data file
+    bool lost; // Rounds couldn't be written, the data file is incomplete
+    char data_fp[64]; // Data file, empty if it couldn't be created
 } GameData;
 
 GameData* create_gm();
 void free_gm(GameData* gm);
 char *create_uf(GameData *gm);
-void add_card(GameData* gm, int card, time_t reaction_time);
+void add_card(GameData* gm, int card, uint64_t reaction_ns);
 void add_round(GameData* gm, int round_lvl, int win);
-void add_loosing_card(GameData *gm, int card, time_t reaction_time);
+void add_loosing_card(GameData *gm, int card, uint64_t reaction_ns);
 int write_data_to_file(GameData* gm);
+int write_player_reaction(GameData *gm, const char *name, const Histogram *h);
 int make_dg(const char* data_fp);
 int make_pdf(const char* data_fp);
-int write_game_rank(GameData* gm, char *p_names[]);
+int write_game_rank(GameData* gm, char *p_names[], int nb_names);
 char **get_top10(int nb_p, int *line_count);
 
 #endif //TEST_STATMANAGERV_H
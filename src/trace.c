@@ -0,0 +1,113 @@
+//
+// Created by erwan on 19/10/2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "trace.h"
+
+typedef struct {
+    const char *name; // Static string
+    uint64_t ts_ns;
+    uint64_t dur_ns;
+    int tid;
+    int room;
+    atomic_bool ready; // Set once the event is complete
+} TraceEvent;
+
+bool trace_enabled = false;
+static const char *trace_path = NULL;
+static TraceEvent *events = NULL;
+static atomic_uint next_event = 0;
+static uint64_t trace_origin = 0;
+static _Thread_local int thread_id = 0;
+static _Thread_local int thread_room = TRACE_NO_ROOM;
+
+uint64_t trace_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief Enable tracing if the THEMIND_TRACE environment variable gives a file path.
+ * @note Must be called once, before any thread is created.
+ */
+void trace_init(void) {
+    trace_path = getenv(TRACE_ENV);
+    if (trace_path == NULL || trace_path[0] == '\0') return;
+    events = calloc(TRACE_MAX_EVENTS, sizeof(TraceEvent));
+    if (events == NULL) {
+        perror("ERROR : trace allocation");
+        return;
+    }
+    trace_origin = trace_now();
+    trace_enabled = true;
+    printf("Trace activée : %s\n", trace_path);
+}
+
+/**
+ * @brief Set the room (game table) of the calling thread, used by spans without an explicit room.
+ */
+void trace_set_room(int room) {
+    thread_room = room;
+}
+
+/**
+ * @brief Record a complete span.
+ * @param start Timestamp returned by trace_now when the span was opened.
+ * @param name Name of the span, must be a static string.
+ * @param room Room of the span, TRACE_NO_ROOM to use the room of the calling thread.
+ */
+void trace_end(uint64_t start, const char *name, int room) {
+    uint64_t end = trace_now();
+    unsigned idx = atomic_fetch_add_explicit(&next_event, 1, memory_order_relaxed);
+    if (idx >= TRACE_MAX_EVENTS) return; // Full : dropped
+
+    if (thread_id == 0) thread_id = (int)syscall(SYS_gettid);
+    TraceEvent *ev = &events[idx];
+    ev->name = name;
+    ev->ts_ns = start - trace_origin;
+    ev->dur_ns = end - start;
+    ev->tid = thread_id;
+    ev->room = room == TRACE_NO_ROOM ? thread_room : room;
+    atomic_store_explicit(&ev->ready, true, memory_order_release);
+}
+
+/**
+ * @brief Write the recorded spans to the trace file, in the Chrome trace-event format.
+ * @return 0 on success, -1 if tracing is disabled or the file can't be written.
+ */
+int trace_flush(void) {
+    if (!trace_enabled) return -1;
+    FILE *file = fopen(trace_path, "w");
+    if (!file) {
+        perror("Erreur lors de l'ouverture du fichier de trace");
+        return -1;
+    }
+
+    unsigned count = atomic_load(&next_event);
+    unsigned dropped = 0;
+    if (count > TRACE_MAX_EVENTS) {
+        dropped = count - TRACE_MAX_EVENTS;
+        count = TRACE_MAX_EVENTS;
+    }
+    int pid = (int)getpid();
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    bool first = true;
+    for (unsigned i = 0; i < count; ++i) {
+        TraceEvent *ev = &events[i];
+        if (!atomic_load_explicit(&ev->ready, memory_order_acquire)) continue;
+        fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"room\":%d}}",
+                first ? "" : ",\n", ev->name, pid, ev->tid, ev->ts_ns / 1000.0, ev->dur_ns / 1000.0, ev->room);
+        first = false;
+    }
+    fprintf(file, "\n],\"otherData\":{\"dropped_spans\":%u}}\n", dropped);
+    fclose(file);
+    printf("Trace écrite : %s (%u spans, %u perdus)\n", trace_path, count, dropped);
+    return 0;
+}
@@ -0,0 +1,34 @@
+//
+// Created by erwan on 19/10/2026.
+//
+
+#ifndef THEMIND_TRACE_H
+#define THEMIND_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TRACE_ENV "THEMIND_TRACE" // Path of the trace file, tracing is off when unset
+#define TRACE_MAX_EVENTS 65536 // Spans beyond this are dropped, memory stays bounded
+#define TRACE_NO_ROOM (-1)
+
+/**
+ * @brief Tracing of the server main paths, exported as Chrome / Perfetto trace-event JSON.
+ *
+ * A span is opened with TRACE_BEGIN and closed with TRACE_END. When tracing is disabled
+ * a span costs one test of a global boolean.
+ */
+
+extern bool trace_enabled;
+
+void trace_init(void);
+void trace_set_room(int room);
+uint64_t trace_now(void);
+void trace_end(uint64_t start, const char *name, int room);
+int trace_flush(void);
+
+#define TRACE_BEGIN(var) uint64_t var = trace_enabled ? trace_now() : 0
+#define TRACE_END(var, name) do { if (var) trace_end(var, name, TRACE_NO_ROOM); } while (0)
+#define TRACE_END_ROOM(var, name, room) do { if (var) trace_end(var, name, room); } while (0)
+
+#endif //THEMIND_TRACE_H
@@ -3,42 +3,52 @@
 //
 #include "utils.h"
 
-char* format_board(int* board, int size) {
-    if (board == NULL || size <= 0) {
-        return NULL;
-    }
+void sb_init(StrBuilder *sb, char *buf, int cap) {
+    sb->buf = buf;
+    sb->cap = cap;
+    sb->len = 0;
+    buf[0] = '\0';
+}
 
-    // Estimation de la taille maximale de la chaîne : "[ , , ,]" (5 * taille + 2 pour les crochets)
-    int max_length = size * 5 + 2;
-    char* result = (char*)malloc(max_length * sizeof(char));
-    if (!result) {
-        perror("Erreur d'allocation mémoire");
-        exit(EXIT_FAILURE);
-    }
+void sb_append(StrBuilder *sb, const char *text, int len) {
+    if (len > sb->cap - 1 - sb->len) len = sb->cap - 1 - sb->len; // Cut
+    memcpy(sb->buf + sb->len, text, len);
+    sb->len += len;
+    sb->buf[sb->len] = '\0';
+}
+
+void sb_str(StrBuilder *sb, const char *s) {
+    sb_append(sb, s, (int)strlen(s));
+}
 
-    // Commencer par le crochet ouvrant
-    strcpy(result, "[");
+void sb_int(StrBuilder *sb, int n) {
+    char text[12];
+    int start = (int)sizeof(text); // Digits written from the end
+    unsigned int u = n < 0 ? -(unsigned int)n : (unsigned int)n;
+    do {
+        text[--start] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u > 0);
+    if (n < 0) text[--start] = '-';
+    sb_append(sb, text + start, (int)sizeof(text) - start);
+}
 
-    // Construire la chaîne
+/**
+ * @brief Append the board : "[3,12, , ]\n", a space for each free slot.
+ */
+void format_board(StrBuilder *sb, const int *board, int size) {
+    SB_LIT(sb, "[");
     for (int i = 0; i < size; i++) {
-        char buffer[12]; // Assez pour stocker un entier
         if (board[i] == 0) {
-            strcat(result, " "); // Ajouter un espace pour les zéros
+            SB_LIT(sb, " "); // Ajouter un espace pour les zéros
         } else {
-            snprintf(buffer, sizeof(buffer), "%d", board[i]);
-            strcat(result, buffer); // Ajouter la valeur
+            sb_int(sb, board[i]);
         }
-
-        // Ajouter une virgule si ce n'est pas le dernier élément
         if (i < size - 1) {
-            strcat(result, ",");
+            SB_LIT(sb, ",");
         }
     }
-
-    // Ajouter le crochet fermant
-    strcat(result, "]\n");
-
-    return result;
+    SB_LIT(sb, "]\n");
 }
 
 int ctoint(const char *cmd) {
@@ -72,6 +82,22 @@ int hash_cmd(const char* cmd){
         return ROBOT_REMOVE;
     else if (strcmp(cmd,"quit") == 0 || strcmp(cmd,"q") == 0)
         return QUIT;
+    else if (strcmp(cmd,"memstats") == 0)
+        return MEMSTATS;
+    else if (strcmp(cmd,"color") == 0)
+        return COLOR;
+    else if (strcmp(cmd,"nocolor") == 0)
+        return NO_COLOR;
+    else if (strcmp(cmd,"delta") == 0)
+        return DELTA;
+    else if (strcmp(cmd,"nodelta") == 0)
+        return NO_DELTA;
+    else if (strcmp(cmd,"state") == 0)
+        return STATE;
+    else if (strcmp(cmd,"profile") == 0 || strncmp(cmd,"profile ",8) == 0)
+        return PROFILE;
+    else if (strcmp(cmd,"analytics") == 0)
+        return ANALYTICS;
     else if (ctoint(cmd) != -1)
         return CARD;
     else return -1;
@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "memstats.h"
 
 #define QUIT 0
 #define READY 1
@@ -17,8 +18,32 @@
 #define ROBOT_ADD 51
 #define ROBOT_REMOVE 52
 #define CARD 6
+#define MEMSTATS 7
+#define COLOR 8
+#define NO_COLOR 9
+#define DELTA 10
+#define NO_DELTA 11
+#define STATE 12
+#define PROFILE 13
+#define ANALYTICS 14
 
-char* format_board(int* board, int size);
+/**
+ * @brief Append-only string over a caller buffer, the text is cut at its capacity and always '\0' terminated.
+ */
+typedef struct {
+    char *buf;
+    int cap; // Size of buf, '\0' included
+    int len;
+} StrBuilder;
+
+#define SB_LIT(sb, lit) sb_append((sb), (lit), (int)sizeof(lit) - 1)
+
+void sb_init(StrBuilder *sb, char *buf, int cap);
+void sb_append(StrBuilder *sb, const char *text, int len);
+void sb_str(StrBuilder *sb, const char *s);
+void sb_int(StrBuilder *sb, int n);
+
+void format_board(StrBuilder *sb, const int *board, int size);
 int ctoint(const char* cmd);
 int hash_cmd(const char* cmd);
 #endif //THEMIND_UTILS_H